@@ -26,6 +26,7 @@ extern void io_unregister(const char* name);
 #endif
 
 #include "draw.h"
+#include "stats.h"
 
 #ifndef CFL_SIZE
 #define CFL_SIZE sizeof(complex float)
@@ -59,9 +60,9 @@ struct {
 
 
 static void export_images(const char* output_prefix, int xdim, int ydim, float windowing[2],
-		bool absolute_windowing, float zoom, enum mode_t mode, enum color_t ctab,
+		bool absolute_windowing, float percentile, float zoom, enum mode_t mode, enum color_t ctab,
 		enum flip_t flip, enum interp_t interpolation, const long dims[DIMS],
-		unsigned long loopflags, long pos[DIMS], const complex float* idata);
+		unsigned long loopflags, long pos[DIMS], const complex float* idata, struct stats_s* st);
 
 
 static const char help_str[] = "Export images to png.";
@@ -84,6 +85,8 @@ int main(int argc, char* argv[argc])
 	int ydim = 0;
 	float windowing[2] = { 0.f, 1.f };
 	bool absolute_windowing = false;
+	float percentile = 0.f;
+	bool stats_cache = false;
 	float zoom =2.f;
 	enum flip_t flip = OO;
 	enum interp_t interpolation = NLINEAR;
@@ -127,6 +130,8 @@ int main(int argc, char* argv[argc])
 		OPT_FLOAT('l', &windowing[0], "l", "lower windowing value"),
 		OPT_FLOAT('u', &windowing[1], "u", "upper windowing value"),
 		OPT_SET('A', &absolute_windowing, "use absolute windowing"),
+		OPT_FLOAT('q', &percentile, "q", "window from the q-th to the (100-q)-th percentile of the magnitude"),
+		OPTL_SET(0, "stats-cache", &stats_cache, "keep statistics in <input>.stats"),
 		OPT_FLOAT('z', &zoom, "z", "zoom factor (default: 2) "),
 		OPT_SUBOPT('C', "cmap", "colormap. -Ch for help.", ARRAY_SIZE(modeopt), modeopt),
 		OPT_SUBOPT('F', "flip", "flip. -Fh for help.", ARRAY_SIZE(flipopt), flipopt),
@@ -150,6 +155,8 @@ int main(int argc, char* argv[argc])
 			&& (windowing[0] < windowing[1]));
 	}
 
+	assert((0.f <= percentile) && (percentile < 50.f));
+
 	assert((0 <= xdim) && (xdim < DIMS));
 	assert((0 <= ydim) && (ydim < DIMS));
 
@@ -182,6 +189,11 @@ int main(int argc, char* argv[argc])
 	long dims[DIMS];
 	complex float* idata = load_cfl(in_file, DIMS, dims);
 
+	struct stats_s* st = create_stats(DIMS, dims, idata);
+
+	if (stats_cache)
+		stats_attach_file(st, in_file);
+
 	char* ext = rindex(out_prefix, '.');
 
 	if (NULL != ext) {
@@ -194,9 +206,11 @@ int main(int argc, char* argv[argc])
 
 
 
-	export_images(out_prefix, xdim, ydim, windowing, absolute_windowing, zoom,
+	export_images(out_prefix, xdim, ydim, windowing, absolute_windowing, percentile, zoom,
 			cm_table[mode].mode, cm_table[mode].ctab, flip, interpolation,
-			dims, ~sliceflags, pos, idata);
+			dims, ~sliceflags, pos, idata, st);
+
+	delete_stats(st);
 
 
 	unmap_cfl(DIMS, dims, idata);
@@ -224,8 +238,8 @@ static void unravel_index(int D, long pos[D], unsigned long flags, const long di
 }
 
 void export_images(const char* output_prefix, int xdim, int ydim, float windowing[2], bool absolute_windowing,
-		float zoom, enum mode_t mode, enum color_t ctab, enum flip_t flip, enum interp_t interpolation,
-		const long dims[DIMS], unsigned long loopflags, long _pos[DIMS], const complex float* idata)
+		float percentile, float zoom, enum mode_t mode, enum color_t ctab, enum flip_t flip, enum interp_t interpolation,
+		const long dims[DIMS], unsigned long loopflags, long _pos[DIMS], const complex float* idata, struct stats_s* st)
 {
 	if (xdim == ydim) {
 
@@ -250,18 +264,26 @@ void export_images(const char* output_prefix, int xdim, int ydim, float windowin
 
 	} else {
 
-		for (long j = 0; j < md_calc_size(DIMS, dims); j++)
-			if (max < cabsf(idata[j]))
-				max = cabsf(idata[j]);
+		max = stats_global(st, MD_BIT(xdim) | MD_BIT(ydim)).max;
 
 		if (0. == max)
 			max = 1.;
 	}
 
+	if (0.f < percentile) {
+
+		const struct histogram_s* h = stats_histogram_global(st, MD_BIT(xdim) | MD_BIT(ydim));
+
+		windowing[0] = stats_percentile(h, percentile / 100.) / max;
+		windowing[1] = stats_percentile(h, 1. - percentile / 100.) / max;
+	}
+
 	int rgbw = dims[xdim] * zoom;
 	int rgbh = dims[ydim] * zoom;
 	int rgbstr = 4 * rgbw;
 
+	bool native = native_zoom(interpolation, zoom, zoom, false);
+
 	// loop over all dims other than xdim and ydim
 	long loopdims[DIMS];
 	loopflags &= ~(MD_BIT(xdim)|MD_BIT(ydim));
@@ -276,8 +298,10 @@ void export_images(const char* output_prefix, int xdim, int ydim, float windowin
 	md_calc_strides(DIMS, strs, dims, sizeof(complex float));
 
 
+	long nimages = md_calc_size(DIMS, loopdims);
+
 #pragma omp parallel for
-	for (unsigned long d = 0l; d < md_calc_size(DIMS, loopdims); ++d) {
+	for (long d = 0l; d < nimages; ++d) {
 
 		long pos[DIMS];
 		md_copy_dims(DIMS, pos, _pos);
@@ -287,7 +311,7 @@ void export_images(const char* output_prefix, int xdim, int ydim, float windowin
 
 		unravel_index(DIMS, pos, loopflags, loopdims, d);
 
-		debug_printf(DP_DEBUG3, "\ti: %lu\n\t", d);
+		debug_printf(DP_DEBUG3, "\ti: %ld\n\t", d);
 		debug_print_dims(DP_DEBUG3, DIMS, pos);
 
 		// Prepare output filename
@@ -295,19 +319,70 @@ void export_images(const char* output_prefix, int xdim, int ydim, float windowin
 
 		debug_printf(DP_DEBUG2, "\t%s\n", name);
 
-		complex float* buf = xmalloc(rgbh * rgbw * sizeof(complex float));
+		unsigned char* rgb = xmalloc(rgbh * rgbstr);
 
-		update_buf(xdim, ydim, DIMS, dims, strs, pos,
-			   flip, interpolation, zoom, zoom, false,
-			   rgbw, rgbh, idata, buf);
+		if (native) {
 
-		unsigned char* rgb = xmalloc(rgbh * rgbstr);
+			// sample and colormap once per pixel, then replicate
+			int nw = dims[xdim];
+			int nh = dims[ydim];
+
+			complex float* buf = xmalloc(nh * nw * sizeof(complex float));
+
+			update_buf(xdim, ydim, DIMS, dims, strs, pos,
+				   flip, interpolation, 1., 1., false,
+				   nw, nh, idata, buf);
+
+			unsigned char* nrgb = xmalloc(nh * nw * 4);
+
+			draw(nw, nh, 4 * nw, (unsigned char(*)[nh][nw][4])nrgb,
+				mode, ctab, 1. / max, windowing[0], windowing[1], 0,
+				nw, buf);
 
-		draw(rgbw, rgbh, rgbstr, (unsigned char(*)[rgbw][rgbstr / 4][4])rgb,
-			mode, ctab, 1. / max, windowing[0], windowing[1], 0,
-			rgbw, buf);
+			draw_replicate(rgbw, rgbh, rgbstr, (unsigned char(*)[rgbh][rgbstr / 4][4])rgb, 0, 0,
+				zoom, zoom, nw, nh, 4 * nw, (const unsigned char(*)[nh][nw][4])nrgb);
 
-		xfree(buf);
+			xfree(nrgb);
+			xfree(buf);
+
+		} else {
+
+			complex float* buf = xmalloc(rgbh * rgbw * sizeof(complex float));
+
+			int f = reduce_factor(zoom);
+
+			if ((1 < f) && ((NLINEAR == interpolation) || (NLINEARMAG == interpolation))) {
+
+				// interpolate from a box-filtered copy to avoid aliasing
+				long rdims[DIMS];
+				complex float* plane = xmalloc(((dims[xdim] + f - 1) / f) * ((dims[ydim] + f - 1) / f) * sizeof(complex float));
+
+				reduce_plane(xdim, ydim, DIMS, dims, strs, pos, f, f, (NLINEARMAG == interpolation), rdims, plane, idata);
+
+				long rstrs[DIMS];
+				md_calc_strides(DIMS, rstrs, rdims, sizeof(complex float));
+
+				long rpos[DIMS] = { 0 };
+
+				update_buf(xdim, ydim, DIMS, rdims, rstrs, rpos,
+					   flip, NLINEAR, zoom * f, zoom * f, false,
+					   rgbw, rgbh, plane, buf);
+
+				xfree(plane);
+
+			} else {
+
+				update_buf(xdim, ydim, DIMS, dims, strs, pos,
+					   flip, interpolation, zoom, zoom, false,
+					   rgbw, rgbh, idata, buf);
+			}
+
+			draw(rgbw, rgbh, rgbstr, (unsigned char(*)[rgbw][rgbstr / 4][4])rgb,
+				mode, ctab, 1. / max, windowing[0], windowing[1], 0,
+				rgbw, buf);
+
+			xfree(buf);
+		}
 
 		if (0 != png_write_bgr32(name, rgbw, rgbh, 0, rgb))
 			error("Error: writing image file.\n");
@@ -10,6 +10,7 @@
 #include <complex.h>
 #include <assert.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "misc/misc.h"
 
@@ -81,49 +82,69 @@ static void trans_magnitude(double rgb[3], enum color_t ctab, double a, double b
 	}
 }
 
-static void trans_real(double rgb[3], enum color_t /* ctab */, double a, double b, complex double value)
+static inline float clampf(float a, float b, float x)
 {
-	rgb[0] *= window(a, b, +creal(value));
-	rgb[1] *= window(a, b, -creal(value));
-	rgb[2] *= 0.;
+	return (x < a) ? a : ((x > b) ? b : x);
 }
 
-static void trans_phase(double rgb[3], enum color_t ctab, double /*a*/, double /*b*/, complex double value)
+static inline float windowf(float a, float b, float x)
 {
-	double arg = carg(value);
+	if (a == b)
+		return (0.f == x) ? 0.f : 1.f;
 
-	switch (ctab) {
+	return clampf(0.f, 1.f, (x - a) / (b - a));
+}
+
+// values are finite here, so the overflow handling of cabsf is not needed
+static inline float magnf(complex float value)
+{
+	return sqrtf(crealf(value) * crealf(value) + cimagf(value) * cimagf(value));
+}
+
+/* Polynomial approximation of atan2 with a maximum error of about 2e-4,
+ * which is below 0.03 of an 8-bit color level for all modes.
+ */
+static inline float fast_atan2f(float y, float x)
+{
+	float ax = fabsf(x);
+	float ay = fabsf(y);
+	float mx = fmaxf(ax, ay);
+	float a = (0.f == mx) ? 0.f : (fminf(ax, ay) / mx);
+	float s = a * a;
+	float r = ((-0.0464964749f * s + 0.15931422f) * s - 0.327622764f) * s * a + a;
+
+	if (ay > ax)
+		r = (float)(M_PI / 2.) - r;
+
+	if (x < 0.f)
+		r = (float)M_PI - r;
+
+	return signbit(y) ? -r : r;
+}
+
+static void trans_phase(double rgb[3], enum color_t ctab, double arg)
+{
+	if (MYGBM == ctab) {
 
-	case MYGBM:
 		double val = (arg + M_PI) / 2. / M_PI;
 		assert((0.0 <= val) && (val <= 1.0));
-	
-		interpolate_cmap(rgb, val, cyclic_mygbm);
-		break;
 
-	default:
-		rgb[0] *= (1. + sin(arg + 0. * 2. * M_PI / 3.)) / 2.;
-		rgb[1] *= (1. + sin(arg + 1. * 2. * M_PI / 3.)) / 2.;
-		rgb[2] *= (1. + sin(arg + 2. * 2. * M_PI / 3.)) / 2.;
-		break;
+		interpolate_cmap(rgb, val, cyclic_mygbm);
+		return;
 	}
-}
 
-static void trans_complex(double rgb[3], enum color_t ctab, double a, double b, complex double value)
-{
-	trans_magnitude(rgb, NONE, a, b, value);
-	trans_phase(rgb, ctab, a, b, value);
+	rgb[0] *= (1. + sin(arg + 0. * 2. * M_PI / 3.)) / 2.;
+	rgb[1] *= (1. + sin(arg + 1. * 2. * M_PI / 3.)) / 2.;
+	rgb[2] *= (1. + sin(arg + 2. * 2. * M_PI / 3.)) / 2.;
 }
 
-static void trans_flow(double rgb[3], enum color_t /* ctab */, double a, double b, complex double value)
+static inline void trans_flowf(float rgb[3], complex float value)
 {
-	trans_magnitude(rgb, NONE, a, b, value);
+	float pha = clampf(-1.f, 1.f, fast_atan2f(cimagf(value), crealf(value)) / (float)M_PI);
 
-	double pha = clamp(-1., 1., carg(value) / M_PI);
-
-	rgb[0] *= (1. + pha) / 2.;
-	rgb[1] *= (1. - fabs(pha)) / 2.;
-	rgb[2] *= (1. - pha) / 2.;
+	rgb[0] *= (1.f + pha) / 2.f;
+	rgb[1] *= (1.f - fabsf(pha)) / 2.f;
+	rgb[2] *= (1.f - pha) / 2.f;
 }
 
 
@@ -132,15 +153,15 @@ static void trans_flow(double rgb[3], enum color_t /* ctab */, double a, double
 static complex float int_nlinear(int N, const float x[N], const long strs[N], const complex float* in)
 {
 	return (0 == N) ? in[0]
-			: (  (1. - x[N - 1]) * int_nlinear(N - 1, x, strs, in + 0)
-		           +       x[N - 1]  * int_nlinear(N - 1, x, strs, in + strs[N - 1]));
+			: (  (1.f - x[N - 1]) * int_nlinear(N - 1, x, strs, in + 0)
+		           +        x[N - 1]  * int_nlinear(N - 1, x, strs, in + strs[N - 1]));
 }
 
 static complex float int_nlinearmag(int N, const float x[N], const long strs[N], const complex float* in)
 {
 	return (0 == N) ? cabsf(in[0])
-			: (  (1. - x[N - 1]) * int_nlinearmag(N - 1, x, strs, in + 0)
-		           +       x[N - 1]  * int_nlinearmag(N - 1, x, strs, in + strs[N - 1]));
+			: (  (1.f - x[N - 1]) * int_nlinearmag(N - 1, x, strs, in + 0)
+		           +        x[N - 1]  * int_nlinearmag(N - 1, x, strs, in + strs[N - 1]));
 }
 
 
@@ -148,13 +169,85 @@ static complex float int_nearest(int N, const float x[N], const long strs[N], co
 {
 	size_t offs = 0;
 
-	for (int i = 0; i < N; ++i)
-		offs += round(x[i]) * strs[i];
+	for (int i = 0; i < N; i++)
+		offs += roundf(x[i]) * strs[i];
 
 	return *(in + offs);
 }
 
 
+// fixed-rank versions of the above for the common low-dimensional cases
+
+static complex float lerp(float x, complex float a, complex float b)
+{
+	return (1.f - x) * a + x * b;
+}
+
+static complex float int_nlinear0(int /*N*/, const float* /*x*/, const long* /*strs*/, const complex float* in)
+{
+	return in[0];
+}
+
+static complex float int_nlinear1(int /*N*/, const float* x, const long* strs, const complex float* in)
+{
+	return lerp(x[0], in[0], in[strs[0]]);
+}
+
+static complex float int_nlinear2(int /*N*/, const float* x, const long* strs, const complex float* in)
+{
+	return lerp(x[1], int_nlinear1(1, x, strs, in), int_nlinear1(1, x, strs, in + strs[1]));
+}
+
+static complex float int_nlinear3(int /*N*/, const float* x, const long* strs, const complex float* in)
+{
+	return lerp(x[2], int_nlinear2(2, x, strs, in), int_nlinear2(2, x, strs, in + strs[2]));
+}
+
+static complex float int_nlinearmag0(int /*N*/, const float* /*x*/, const long* /*strs*/, const complex float* in)
+{
+	return cabsf(in[0]);
+}
+
+static complex float int_nlinearmag1(int /*N*/, const float* x, const long* strs, const complex float* in)
+{
+	return lerp(x[0], cabsf(in[0]), cabsf(in[strs[0]]));
+}
+
+static complex float int_nlinearmag2(int /*N*/, const float* x, const long* strs, const complex float* in)
+{
+	return lerp(x[1], int_nlinearmag1(1, x, strs, in), int_nlinearmag1(1, x, strs, in + strs[1]));
+}
+
+static complex float int_nlinearmag3(int /*N*/, const float* x, const long* strs, const complex float* in)
+{
+	return lerp(x[2], int_nlinearmag2(2, x, strs, in), int_nlinearmag2(2, x, strs, in + strs[2]));
+}
+
+static complex float int_nearest1(int /*N*/, const float* x, const long* strs, const complex float* in)
+{
+	return in[(x[0] >= 0.5f) ? strs[0] : 0];
+}
+
+static complex float int_nearest2(int /*N*/, const float* x, const long* strs, const complex float* in)
+{
+	return int_nearest1(1, x, strs, in + ((x[1] >= 0.5f) ? strs[1] : 0));
+}
+
+static complex float int_nearest3(int /*N*/, const float* x, const long* strs, const complex float* in)
+{
+	return int_nearest2(2, x, strs, in + ((x[2] >= 0.5f) ? strs[2] : 0));
+}
+
+typedef complex float interp_fun_t(int N, const float x[N], const long strs[N], const complex float* in);
+
+// indexed by the number of active dimensions, the last entry is the general case
+static interp_fun_t* interp_funs[][5] = {
+	[NLINEAR] = { int_nlinear0, int_nlinear1, int_nlinear2, int_nlinear3, int_nlinear },
+	[NLINEARMAG] = { int_nlinearmag0, int_nlinearmag1, int_nlinearmag2, int_nlinearmag3, int_nlinearmag },
+	[NEAREST] = { int_nlinear0, int_nearest1, int_nearest2, int_nearest3, int_nearest },
+};
+
+
 static complex float lic_sample(int N, const float pos[N], const long dims[N], const long strs[N], const complex float* in);
 
 complex float sample(int N, const float pos[N], const long dims[N], const long strs[N], enum interp_t interpolation, const complex float* in)
@@ -211,20 +304,9 @@ complex float sample(int N, const float pos[N], const long dims[N], const long s
 	for (int i = 0; i < N; i++)
 		off0 += div[i] * strs[i];
 
-	switch (interpolation) {
-
-	case NLINEAR:
-		return int_nlinear(D, rem, strs2, (const complex float*)(((char*)in) + off0));
-
-	case NLINEARMAG:
-		return int_nlinearmag(D, rem, strs2, (const complex float*)(((char*)in) + off0));
-
-	case NEAREST:
-		return int_nearest(D, rem, strs2, (const complex float*)(((char*)in) + off0));
+	assert(interpolation < ARRAY_SIZE(interp_funs));
 
-	default:
-		assert(0);
-	}
+	return interp_funs[interpolation][MIN(D, 4)](D, rem, strs2, (const complex float*)(((char*)in) + off0));
 }
 
 
@@ -307,92 +389,858 @@ complex float lic_sample(int N, const float pos[N], const long dims[N], const lo
  * positions.
  **/
 
-extern void resample(int X, int Y, long str, complex float* buf,
-	int N, const double pos[N], const double dx[N], const double dy[N], 
-	const long dims[N], const long strs[N], enum interp_t interpolation, const complex float* in)
+static double resample_start(double dx, double dy)
+{
+	/* start is only != 0 if dx or dy are != 0.
+	 * Further, for negative dx/dy, it needs the same sign.
+	 * ....0.......1....	d	(|d| - 1.) / 2.
+	 * |---*---|---*---|	1.00 ->	-0.000
+	 * |-*-|-*-|-*-|-*-|	0.50 ->	-0.250
+	 * |*|*|*|*|*|*|*|*|	0.25 ->	-0.375
+	 **/
+
+	return	- (dx != 0.) * copysign((fabs(dx) - 1.) / 2., dx)
+		- (dy != 0.) * copysign((fabs(dy) - 1.) / 2., dy);
+}
+
+
+/* Clamp a position along one axis to the valid range in the same way
+ * as sample() does and split it into an integer and a fractional part.
+ */
+static long resample_split(long dim, float pos, float* rem)
+{
+	*rem = 0.;
+
+	if (dim <= 1)
+		return 0;
+
+	if (pos < 0.)
+		return 0;
+
+	if (pos > dim - 1)
+		return dim - 1;
+
+	*rem = pos - truncf(pos);
+
+	return truncf(pos);
+}
+
+
+/* For each output column (or row) we store the indices of the two
+ * neighbouring input samples along the axis and the weight of the
+ * second one. This is all that changes between pixels when only one
+ * input dimension varies along each output axis.
+ */
+struct resample_tap_s {
+
+	long idx[2];
+	float w;
+};
+
+struct resample_axis_s {
+
+	long len;	// input samples along the axis
+	long str;	// distance between them in elements
+	bool active;	// any non-zero weights
+
+	struct resample_tap_s* tap;
+};
+
+static void resample_axis(int X, struct resample_axis_s* ax, int d, int N,
+	const double pos[N], const double dx[N], const double dy[N],
+	const long dims[N], const long strs[N], enum interp_t interpolation)
+{
+	ax->len = (-1 == d) ? 1 : dims[d];
+	ax->str = (-1 == d) ? 0 : strs[d] / (long)sizeof(complex float);
+	ax->active = false;
+	ax->tap = xmalloc(X * sizeof(struct resample_tap_s));
+
+	for (int x = 0; x < X; x++) {
+
+		ax->tap[x] = (struct resample_tap_s){ { 0, 0 }, 0. };
+
+		if (-1 == d)
+			continue;
+
+		const double* dd = (0. != dx[d]) ? dx : dy;
+
+		float rem;
+		long div = resample_split(dims[d], pos[d] + resample_start(dx[d], dy[d]) + x * dd[d], &rem);
+
+		if (NEAREST == interpolation) {
+
+			div += roundf(rem);
+			rem = 0.;
+		}
+
+		ax->tap[x].idx[0] = div;
+		ax->tap[x].idx[1] = div + ((0. != rem) ? 1 : 0);
+		ax->tap[x].w = rem;
+
+		if (0. != rem)
+			ax->active = true;
+	}
+}
+
+
+/* Row kernels for the table-driven path. The variants are specialized
+ * for whether the x and/or y weights are used at all, which is decided
+ * once per frame. The suffix gives the axes which are interpolated.
+ */
+typedef void row_fun_t(int X, complex float* out, const struct resample_axis_s* xax,
+	float wy, const complex float* in0, const complex float* in1, complex float* tmp);
+
+static void row_nlinear0(int X, complex float* out, const struct resample_axis_s* xax,
+	float /*wy*/, const complex float* in0, const complex float* /*in1*/, complex float* /*tmp*/)
+{
+	for (int x = 0; x < X; x++)
+		out[x] = in0[xax->tap[x].idx[0] * xax->str];
+}
+
+static void row_nlinear_x(int X, complex float* out, const struct resample_axis_s* xax,
+	float /*wy*/, const complex float* in0, const complex float* /*in1*/, complex float* /*tmp*/)
+{
+	for (int x = 0; x < X; x++) {
+
+		const struct resample_tap_s* t = &xax->tap[x];
+
+		out[x] = lerp(t->w, in0[t->idx[0] * xax->str], in0[t->idx[1] * xax->str]);
+	}
+}
+
+static void row_nlinear_y(int X, complex float* out, const struct resample_axis_s* xax,
+	float wy, const complex float* in0, const complex float* in1, complex float* /*tmp*/)
+{
+	for (int x = 0; x < X; x++) {
+
+		long o = xax->tap[x].idx[0] * xax->str;
+
+		out[x] = lerp(wy, in0[o], in1[o]);
+	}
+}
+
+static void row_nlinear_xy(int X, complex float* out, const struct resample_axis_s* xax,
+	float wy, const complex float* in0, const complex float* in1, complex float* /*tmp*/)
+{
+	for (int x = 0; x < X; x++) {
+
+		const struct resample_tap_s* t = &xax->tap[x];
+
+		long o0 = t->idx[0] * xax->str;
+		long o1 = t->idx[1] * xax->str;
+
+		out[x] = lerp(wy, lerp(t->w, in0[o0], in0[o1]), lerp(t->w, in1[o0], in1[o1]));
+	}
+}
+
+static void row_nlinearmag0(int X, complex float* out, const struct resample_axis_s* xax,
+	float /*wy*/, const complex float* in0, const complex float* /*in1*/, complex float* /*tmp*/)
+{
+	for (int x = 0; x < X; x++)
+		out[x] = cabsf(in0[xax->tap[x].idx[0] * xax->str]);
+}
+
+static void row_nlinearmag_x(int X, complex float* out, const struct resample_axis_s* xax,
+	float /*wy*/, const complex float* in0, const complex float* /*in1*/, complex float* /*tmp*/)
+{
+	for (int x = 0; x < X; x++) {
+
+		const struct resample_tap_s* t = &xax->tap[x];
+
+		out[x] = lerp(t->w, cabsf(in0[t->idx[0] * xax->str]), cabsf(in0[t->idx[1] * xax->str]));
+	}
+}
+
+static void row_nlinearmag_y(int X, complex float* out, const struct resample_axis_s* xax,
+	float wy, const complex float* in0, const complex float* in1, complex float* /*tmp*/)
 {
-#pragma omp parallel for collapse(2)
 	for (int x = 0; x < X; x++) {
-		for (int y = 0; y < Y; y++) {
 
-			float pos2[N];
+		long o = xax->tap[x].idx[0] * xax->str;
 
-			for (int i = 0; i < N; i++) {
+		out[x] = lerp(wy, cabsf(in0[o]), cabsf(in1[o]));
+	}
+}
 
-				/* start is only != 0 if dx or dy are != 0.
-				 * Further, for negative dx/dy, it needs the same sign.
-				 * ....0.......1....	d	(|d| - 1.) / 2.
-				 * |---*---|---*---|	1.00 ->	-0.000
-				 * |-*-|-*-|-*-|-*-|	0.50 ->	-0.250
-				 * |*|*|*|*|*|*|*|*|	0.25 ->	-0.375
-				 **/
+static void row_nlinearmag_xy(int X, complex float* out, const struct resample_axis_s* xax,
+	float wy, const complex float* in0, const complex float* in1, complex float* /*tmp*/)
+{
+	for (int x = 0; x < X; x++) {
+
+		const struct resample_tap_s* t = &xax->tap[x];
+
+		long o0 = t->idx[0] * xax->str;
+		long o1 = t->idx[1] * xax->str;
+
+		out[x] = lerp(wy, lerp(t->w, cabsf(in0[o0]), cabsf(in0[o1])),
+				  lerp(t->w, cabsf(in1[o0]), cabsf(in1[o1])));
+	}
+}
 
-				double start = 	- (dx[i] != 0.) * copysign((fabs(dx[i]) - 1.) / 2., dx[i])
-						- (dy[i] != 0.) * copysign((fabs(dy[i]) - 1.) / 2., dy[i]);
 
-				pos2[i] = pos[i] + start + x * dx[i] + y * dy[i];
+/* Bilinear interpolation for magnification: we first blend the two input
+ * rows for all input columns and then interpolate along the output row
+ * from this (cache-resident) temporary. The first pass is a simple
+ * streaming loop which is vectorized. On x86-64 we additionally build an
+ * AVX2 version which is selected at runtime if the CPU supports it.
+ */
+#if defined(__x86_64__) && defined(__linux__) && !defined(__clang__)
+#define TARGET_CLONES __attribute__((target_clones("avx2", "default")))
+#else
+#define TARGET_CLONES
+#endif
+
+TARGET_CLONES
+static void blend_rows(long J, complex float* _out, long str, float wy, const complex float* _in0, const complex float* _in1)
+{
+	float (*out)[2] = (float (*)[2])_out;
+	const float (*in0)[2] = (const float (*)[2])_in0;
+	const float (*in1)[2] = (const float (*)[2])_in1;
+
+#pragma omp simd
+	for (long j = 0; j < J; j++) {
+
+		out[j][0] = (1.f - wy) * in0[j * str][0] + wy * in1[j * str][0];
+		out[j][1] = (1.f - wy) * in0[j * str][1] + wy * in1[j * str][1];
+	}
+}
+
+TARGET_CLONES
+static void blend_rows_mag(long J, complex float* _out, long str, float wy, const complex float* _in0, const complex float* _in1)
+{
+	float (*out)[2] = (float (*)[2])_out;
+	const float (*in0)[2] = (const float (*)[2])_in0;
+	const float (*in1)[2] = (const float (*)[2])_in1;
+
+#pragma omp simd
+	for (long j = 0; j < J; j++) {
+
+		float m0 = sqrtf(in0[j * str][0] * in0[j * str][0] + in0[j * str][1] * in0[j * str][1]);
+		float m1 = sqrtf(in1[j * str][0] * in1[j * str][0] + in1[j * str][1] * in1[j * str][1]);
+
+		out[j][0] = (1.f - wy) * m0 + wy * m1;
+		out[j][1] = 0.f;
+	}
+}
+
+static void row_blend(int X, complex float* out, const struct resample_axis_s* xax, const complex float* tmp)
+{
+	for (int x = 0; x < X; x++) {
+
+		const struct resample_tap_s* t = &xax->tap[x];
+
+		out[x] = lerp(t->w, tmp[t->idx[0]], tmp[t->idx[1]]);
+	}
+}
+
+// the input columns used by a part of a row (the taps are monotonic)
+static void row_range(int X, const struct resample_axis_s* xax, long* j0, long* j1)
+{
+	*j0 = MIN(xax->tap[0].idx[0], xax->tap[X - 1].idx[0]);
+	*j1 = MAX(xax->tap[0].idx[1], xax->tap[X - 1].idx[1]);
+}
+
+static void row_nlinear_xy2(int X, complex float* out, const struct resample_axis_s* xax,
+	float wy, const complex float* in0, const complex float* in1, complex float* tmp)
+{
+	long j0, j1;
+	row_range(X, xax, &j0, &j1);
+
+	blend_rows(j1 - j0 + 1, tmp + j0, xax->str, wy, in0 + j0 * xax->str, in1 + j0 * xax->str);
+	row_blend(X, out, xax, tmp);
+}
+
+static void row_nlinearmag_xy2(int X, complex float* out, const struct resample_axis_s* xax,
+	float wy, const complex float* in0, const complex float* in1, complex float* tmp)
+{
+	long j0, j1;
+	row_range(X, xax, &j0, &j1);
+
+	blend_rows_mag(j1 - j0 + 1, tmp + j0, xax->str, wy, in0 + j0 * xax->str, in1 + j0 * xax->str);
+	row_blend(X, out, xax, tmp);
+}
+
+
+// indexed by (x interpolated) | (y interpolated) << 1 | (magnified) << 2
+static row_fun_t* row_funs[][8] = {
+	[NLINEAR] = {	row_nlinear0, row_nlinear_x, row_nlinear_y, row_nlinear_xy,
+			row_nlinear0, row_nlinear_x, row_nlinear_y, row_nlinear_xy2 },
+	[NLINEARMAG] = { row_nlinearmag0, row_nlinearmag_x, row_nlinearmag_y, row_nlinearmag_xy,
+			row_nlinearmag0, row_nlinearmag_x, row_nlinearmag_y, row_nlinearmag_xy2 },
+	[NEAREST] = {	row_nlinear0, row_nlinear0, row_nlinear0, row_nlinear0,
+			row_nlinear0, row_nlinear0, row_nlinear0, row_nlinear0 },
+};
+
+
+/* Find the only input dimension that changes along an output axis.
+ * Returns -1 if there is none and -2 if the geometry is not separable.
+ */
+static int resample_axis_dim(int N, const double d[N], const double o[N])
+{
+	int r = -1;
+
+	for (int i = 0; i < N; i++) {
+
+		if (0. == d[i])
+			continue;
+
+		if ((-1 != r) || (0. != o[i]))
+			return -2;
+
+		r = i;
+	}
+
+	return r;
+}
+
+
+static bool resample_tables(int X, int Y, struct resample_axis_s* xax, struct resample_axis_s* yax, long* off0,
+	int N, const double pos[N], const double dx[N], const double dy[N],
+	const long dims[N], const long strs[N], enum interp_t interpolation)
+{
+	if (LIINCO == interpolation)
+		return false;
+
+	int xd = resample_axis_dim(N, dx, dy);
+	int yd = resample_axis_dim(N, dy, dx);
+
+	if ((-2 == xd) || (-2 == yd))
+		return false;
+
+	*off0 = 0;
+
+	for (int i = 0; i < N; i++) {
+
+		if ((i == xd) || (i == yd))
+			continue;
+
+		float rem;
+		long div = resample_split(dims[i], pos[i], &rem);
+
+		// fractional positions in other dims need full n-linear interpolation
+		if (0. != rem)
+			return false;
+
+		*off0 += div * (strs[i] / (long)sizeof(complex float));
+	}
+
+	resample_axis(X, xax, xd, N, pos, dx, dy, dims, strs, interpolation);
+	resample_axis(Y, yax, yd, N, pos, dx, dy, dims, strs, interpolation);
+
+	return true;
+}
+
+
+/* Rendering is split into tiles of TILE_SIZE x TILE_SIZE output pixels
+ * which are processed in row-major order and distributed dynamically
+ * over the threads, so each thread works on a compact block of the
+ * input and output buffers.
+ */
+extern int tiles_count(int X, int Y)
+{
+	return ((X + TILE_SIZE - 1) / TILE_SIZE) * ((Y + TILE_SIZE - 1) / TILE_SIZE);
+}
+
+struct tile_s { int x0; int x1; int y0; int y1; };
+
+static struct tile_s tile_get(int X, int Y, int t)
+{
+	int tx = (X + TILE_SIZE - 1) / TILE_SIZE;
+
+	int x0 = (t % tx) * TILE_SIZE;
+	int y0 = (t / tx) * TILE_SIZE;
+
+	return (struct tile_s){ x0, MIN(X, x0 + TILE_SIZE), y0, MIN(Y, y0 + TILE_SIZE) };
+}
+
+// mark all tiles which intersect the rectangle [x0, x1] x [y0, y1]
+extern void tiles_mark(int X, int Y, bool* mask, int x0, int y0, int x1, int y1)
+{
+	int T = tiles_count(X, Y);
+
+	for (int i = 0; i < T; i++) {
+
+		struct tile_s t = tile_get(X, Y, i);
+
+		if ((x0 < t.x1) && (t.x0 <= x1) && (y0 < t.y1) && (t.y0 <= y1))
+			mask[i] = true;
+	}
+}
+
+
+#ifndef LUT_SIZE
+#define LUT_SIZE 4096
+#endif
+
+// colors for windowed values in [0, 1], depends only on mode and color table
+struct lut_s {
+
+	bool valid;
+	enum mode_t mode;
+	enum color_t ctab;
+
+	unsigned char tab[LUT_SIZE][4];
+};
+
+// one per render thread, only rebuilt when mode or color table change
+static _Thread_local struct lut_s lut_cache;
+
+static const struct lut_s* lut_get(enum mode_t mode, enum color_t ctab)
+{
+	// REAL uses a gray ramp for both channels
+	if (REAL == mode)
+		ctab = NONE;
+
+	struct lut_s* lut = &lut_cache;
+
+	if (lut->valid && (lut->mode == mode) && (lut->ctab == ctab))
+		return lut;
+
+	for (int i = 0; i < LUT_SIZE; i++) {
+
+		double rgb[3] = { 1., 1., 1. };
+		double x = i / (LUT_SIZE - 1.);
+
+		// identity window, x is already windowed
+		trans_magnitude(rgb, ctab, 0., 1., x);
+
+		lut->tab[i][0] = 255. * rgb[2];
+		lut->tab[i][1] = 255. * rgb[1];
+		lut->tab[i][2] = 255. * rgb[0];
+		lut->tab[i][3] = 255.;
+	}
+
+	lut->valid = true;
+	lut->mode = mode;
+	lut->ctab = ctab;
+
+	return lut;
+}
+
+#ifndef PHASE_LUT_SIZE
+#define PHASE_LUT_SIZE 4096
+#endif
+
+// colors for the phase in [-pi, pi), depends only on the color table
+struct phase_lut_s {
+
+	bool valid;
+	enum color_t ctab;
+
+	float tab[PHASE_LUT_SIZE][3];
+};
+
+static _Thread_local struct phase_lut_s phase_lut_cache;
+
+static const struct phase_lut_s* phase_lut_get(enum color_t ctab)
+{
+	// only MYGBM has its own phase colors
+	if (MYGBM != ctab)
+		ctab = NONE;
+
+	struct phase_lut_s* lut = &phase_lut_cache;
+
+	if (lut->valid && (lut->ctab == ctab))
+		return lut;
+
+	for (int i = 0; i < PHASE_LUT_SIZE; i++) {
+
+		double rgb[3] = { 1., 1., 1. };
+
+		trans_phase(rgb, ctab, -M_PI + 2. * M_PI * i / PHASE_LUT_SIZE);
+
+		for (int c = 0; c < 3; c++)
+			lut->tab[i][c] = rgb[c];
+	}
+
+	lut->valid = true;
+	lut->ctab = ctab;
+
+	return lut;
+}
+
+static inline const float* phase_color(const struct phase_lut_s* lut, complex float value)
+{
+	float arg = fast_atan2f(cimagf(value), crealf(value));
+
+	// the table is periodic (MYGBM is a cyclic color map)
+	int i = (int)((arg + (float)M_PI) * (PHASE_LUT_SIZE / (2. * M_PI)) + 0.5f);
+
+	return lut->tab[i & (PHASE_LUT_SIZE - 1)];
+}
+
+struct draw_params_s;
+
+typedef void draw_row_fun_t(int X, unsigned char (*pixel)[4], const struct draw_params_s* dp, const complex float* buf);
+
+struct draw_params_s {
+
+	draw_row_fun_t* row;
+
+	enum mode_t mode;
+	enum color_t ctab;
+	float scale;
+	float winlow;
+	float winhigh;
+	float phrot;
+
+	// table lookup for MAGN and REAL
+	const struct lut_s* lut;
+
+	// table lookup for PHASE and CMPLX
+	const struct phase_lut_s* phase;
+};
+
+static draw_row_fun_t* draw_row_funs[2][FLOW + 1];
+
+static struct draw_params_s draw_params(enum mode_t mode, enum color_t ctab, float scale, float winlow, float winhigh, float phrot)
+{
+	assert(mode <= FLOW);
+	assert(ctab <= NAVIA);
+
+	struct draw_params_s dp = { draw_row_funs[0. != phrot][mode], mode, ctab, scale, winlow, winhigh, phrot, NULL, NULL };
+
+	if ((MAGN == mode) || (REAL == mode))
+		dp.lut = lut_get(mode, ctab);
+
+	if ((PHASE == mode) || (CMPLX == mode))
+		dp.phase = phase_lut_get(ctab);
+
+	return dp;
+}
+
+// index into the table, as window() but quantized
+static inline int lut_index(float a, float b, float x)
+{
+	return (int)(windowf(a, b, x) * (LUT_SIZE - 1) + 0.5f);
+}
+
+static inline void store_rgb(unsigned char pixel[4], const float rgb[3])
+{
+	pixel[0] = 255.f * rgb[2];
+	pixel[1] = 255.f * rgb[1];
+	pixel[2] = 255.f * rgb[0];
+	pixel[3] = 255;
+}
+
+/* Colors for finite, scaled and rotated values. The color table is
+ * either in the lookup table or fixed by the function.
+ */
+static inline void color_magn(unsigned char pixel[4], const struct draw_params_s* dp, complex float val)
+{
+	memcpy(pixel, dp->lut->tab[lut_index(dp->winlow, dp->winhigh, magnf(val))], 4);
+}
+
+static inline void color_real(unsigned char pixel[4], const struct draw_params_s* dp, complex float val)
+{
+	pixel[0] = 0;
+	pixel[1] = dp->lut->tab[lut_index(dp->winlow, dp->winhigh, -crealf(val))][1];
+	pixel[2] = dp->lut->tab[lut_index(dp->winlow, dp->winhigh, +crealf(val))][2];
+	pixel[3] = 255;
+}
+
+static inline void color_phase(unsigned char pixel[4], const struct draw_params_s* dp, complex float val)
+{
+	store_rgb(pixel, phase_color(dp->phase, val));
+}
+
+static inline void color_cmplx(unsigned char pixel[4], const struct draw_params_s* dp, complex float val)
+{
+	float m = windowf(dp->winlow, dp->winhigh, magnf(val));
+	const float* pc = phase_color(dp->phase, val);
+	float rgb[3] = { m * pc[0], m * pc[1], m * pc[2] };
+	store_rgb(pixel, rgb);
+}
+
+static inline void color_flow(unsigned char pixel[4], const struct draw_params_s* dp, complex float val)
+{
+	float m = windowf(dp->winlow, dp->winhigh, magnf(val));
+	float rgb[3] = { m, m, m };
+	trans_flowf(rgb, val);
+	store_rgb(pixel, rgb);
+}
+
+/* One row kernel per color function, with and without phase rotation.
+ */
+#define DRAW_ROW(NAME, COLOR, ROT)									\
+static void draw_row_ ## NAME(int X, unsigned char (*pixel)[4], const struct draw_params_s* dp, const complex float* buf) \
+{													\
+	float c = ROT ? cosf(dp->phrot) : 1.f;								\
+	float s = ROT ? sinf(dp->phrot) : 0.f;								\
+													\
+	for (int x = 0; x < X; x++) {									\
+													\
+		complex float val = buf[x] * dp->scale;							\
+													\
+		if (!(isfinite(crealf(val)) && isfinite(cimagf(val)))) {				\
+													\
+			memcpy(pixel[x], (unsigned char[4]){ 0, 0, 0, 255 }, 4);			\
+			continue;									\
+		}											\
+													\
+		if (ROT)										\
+			val = CMPLXF(crealf(val) * c - cimagf(val) * s, crealf(val) * s + cimagf(val) * c); \
+													\
+		COLOR(pixel[x], dp, val);								\
+	}												\
+}
+
+#define DRAW_ROWS(NAME, COLOR)	\
+	DRAW_ROW(NAME, COLOR, false)	\
+	DRAW_ROW(NAME ## _rot, COLOR, true)
+
+DRAW_ROW(magn, color_magn, false)
+DRAW_ROWS(real, color_real)
+DRAW_ROWS(phase, color_phase)
+DRAW_ROWS(cmplx, color_cmplx)
+DRAW_ROWS(flow, color_flow)
+
+#undef DRAW_ROWS
+#undef DRAW_ROW
+
+// indexed by rotation and mode, the color table itself is in the lookup tables
+static draw_row_fun_t* draw_row_funs[2][FLOW + 1] = {
+	{
+		[MAGN] = draw_row_magn,
+		[CMPLX] = draw_row_cmplx,
+		[PHASE] = draw_row_phase,
+		[REAL] = draw_row_real,
+		[FLOW] = draw_row_flow,
+	}, {
+		// the magnitude does not depend on the rotation
+		[MAGN] = draw_row_magn,
+		[CMPLX] = draw_row_cmplx_rot,
+		[PHASE] = draw_row_phase_rot,
+		[REAL] = draw_row_real_rot,
+		[FLOW] = draw_row_flow_rot,
+	},
+};
+
+static void draw_row(int X, unsigned char (*pixel)[4], const struct draw_params_s* dp, const complex float* buf)
+{
+	dp->row(X, pixel, dp, buf);
+}
+
+
+/* Rows are either stored in buf or, if dp is given, colorized into rgbbuf
+ * directly from a per-thread line buffer.
+ */
+static void resample_tiles(int X, int Y, long str, complex float* buf,
+	int N, const double pos[N], const double dx[N], const double dy[N],
+	const long dims[N], const long strs[N], enum interp_t interpolation, const complex float* in,
+	const struct draw_params_s* dp, int rgbstr, unsigned char (*rgbbuf)[Y][rgbstr / 4][4])
+{
+	int T = tiles_count(X, Y);
+
+	struct resample_axis_s xax;
+	struct resample_axis_s yax;
+
+	long off0;
+
+	if (resample_tables(X, Y, &xax, &yax, &off0, N, pos, dx, dy, dims, strs, interpolation)) {
+
+		in += off0;
+
+		assert(interpolation < ARRAY_SIZE(row_funs));
+
+		row_fun_t* row = row_funs[interpolation][  (xax.active ? 1 : 0)
+							 | (yax.active ? 2 : 0)
+							 | ((X >= xax.len) ? 4 : 0)];
+
+#pragma omp parallel
+		{
+			complex float* tmp = xmalloc(xax.len * sizeof(complex float));
+			complex float* line = (NULL != dp) ? xmalloc(TILE_SIZE * sizeof(complex float)) : NULL;
+
+#pragma omp for schedule(dynamic)
+			for (int i = 0; i < T; i++) {
+
+				struct tile_s t = tile_get(X, Y, i);
+
+				struct resample_axis_s xax2 = xax;
+				xax2.tap += t.x0;
+
+				for (int y = t.y0; y < t.y1; y++) {
+
+					const struct resample_tap_s* yt = &yax.tap[y];
+
+					row(t.x1 - t.x0, (NULL != dp) ? line : (buf + str * y + t.x0), &xax2, yt->w,
+						in + yt->idx[0] * yax.str, in + yt->idx[1] * yax.str, tmp);
+
+					if (NULL != dp)
+						draw_row(t.x1 - t.x0, &(*rgbbuf)[y][t.x0], dp, line);
+				}
 			}
 
-			buf[str * y + x] = sample(N, pos2, dims, strs, interpolation, in);
+			if (NULL != dp)
+				xfree(line);
+
+			xfree(tmp);
 		}
+
+		xfree(xax.tap);
+		xfree(yax.tap);
+
+		return;
 	}
+
+#pragma omp parallel
+	{
+		complex float line[TILE_SIZE];
+
+#pragma omp for schedule(dynamic)
+		for (int k = 0; k < T; k++) {
+
+			struct tile_s t = tile_get(X, Y, k);
+
+			for (int y = t.y0; y < t.y1; y++) {
+
+				complex float* out = (NULL != dp) ? line : (buf + str * y + t.x0);
+
+				for (int x = t.x0; x < t.x1; x++) {
+
+					float pos2[N];
+
+					for (int i = 0; i < N; i++)
+						pos2[i] = pos[i] + resample_start(dx[i], dy[i]) + x * dx[i] + y * dy[i];
+
+					out[x - t.x0] = sample(N, pos2, dims, strs, interpolation, in);
+				}
+
+				if (NULL != dp)
+					draw_row(t.x1 - t.x0, &(*rgbbuf)[y][t.x0], dp, line);
+			}
+		}
+	}
+}
+
+extern void resample(int X, int Y, long str, complex float* buf,
+	int N, const double pos[N], const double dx[N], const double dy[N],
+	const long dims[N], const long strs[N], enum interp_t interpolation, const complex float* in)
+{
+	resample_tiles(X, Y, str, buf, N, pos, dx, dy, dims, strs, interpolation, in, NULL, 0, NULL);
 }
 
+extern void resample_draw(int X, int Y, int rgbstr, unsigned char (*rgbbuf)[Y][rgbstr / 4][4],
+	enum mode_t mode, enum color_t ctab, float scale, float winlow, float winhigh, float phrot,
+	int N, const double pos[N], const double dx[N], const double dy[N],
+	const long dims[N], const long strs[N], enum interp_t interpolation, const complex float* in)
+{
+	struct draw_params_s dp = draw_params(mode, ctab, scale, winlow, winhigh, phrot);
 
+	resample_tiles(X, Y, 0, NULL, N, pos, dx, dy, dims, strs, interpolation, in, &dp, rgbstr, rgbbuf);
+}
 
 
 
 
+
+
+/* Only tiles with mask[t] set are drawn, all if mask is NULL.
+ */
+extern void draw_tiles(int X, int Y, int rgbstr, unsigned char (*rgbbuf)[Y][rgbstr / 4][4],
+	enum mode_t mode, enum color_t ctab, float scale, float winlow, float winhigh, float phrot,
+	long str, const complex float* buf, const bool* mask)
+{
+	int T = tiles_count(X, Y);
+
+	struct draw_params_s dp = draw_params(mode, ctab, scale, winlow, winhigh, phrot);
+
+#pragma omp parallel for schedule(dynamic)
+	for (int i = 0; i < T; i++) {
+
+		if ((NULL != mask) && !mask[i])
+			continue;
+
+		struct tile_s t = tile_get(X, Y, i);
+
+		for (int y = t.y0; y < t.y1; y++)
+			draw_row(t.x1 - t.x0, &(*rgbbuf)[y][t.x0], &dp, buf + str * y + t.x0);
+	}
+}
+
+
 extern void draw(int X, int Y, int rgbstr, unsigned char (*rgbbuf)[Y][rgbstr / 4][4],
 	enum mode_t mode, enum color_t ctab, float scale, float winlow, float winhigh, float phrot,
 	long str, const complex float* buf)
 {
-#pragma omp parallel for collapse(2)
-	for (int x = 0; x < X; x++) {
-		for (int y = 0; y < Y; y++) {
+	draw_tiles(X, Y, rgbstr, rgbbuf, mode, ctab, scale, winlow, winhigh, phrot, str, buf, NULL);
+}
+
+
+/* For zoom factors below one we interpolate from a reduced copy of the
+ * plane to avoid aliasing. reduce_factor() gives the reduction along one
+ * axis (a power of two, so that the effective zoom stays in (0.5, 1]).
+ */
+extern int reduce_factor(double zoom)
+{
+	int f = 1;
 
-			double rgb[3] = { 1., 1., 1. };
+	while (2. * f * zoom <= 1.)
+		f *= 2;
 
-			complex float val = scale * buf[str * y + x];
+	return f;
+}
 
-			if (isfinite(crealf(val)) && isfinite(cimagf(val))) {
+/* Box-filtered copy of the plane spanned by xdim and ydim at pos, reduced
+ * by fx and fy along these dimensions. The reduced dimensions are returned
+ * in odims and out must have space for odims[xdim] * odims[ydim] elements.
+ */
+extern void reduce_plane(long xdim, long ydim, int N, const long dims[N], const long strs[N], const long pos[N],
+	int fx, int fy, bool mag, long odims[N], complex float* out, const complex float* in)
+{
+	assert(xdim != ydim);
 
-				val *= cexpf(1.i * phrot);
+	long off0 = 0;
 
-				switch (mode) {
+	for (int i = 0; i < N; i++) {
 
-				case MAGN: trans_magnitude(rgb, ctab, winlow, winhigh, val); break;
-				case PHASE: trans_phase(rgb, ctab, winlow, winhigh, val); break;
-				case CMPLX: trans_complex(rgb, ctab, winlow, winhigh, val); break;
-				case REAL: trans_real(rgb, ctab, winlow, winhigh, val); break;
-				case FLOW: trans_flow(rgb, ctab, winlow, winhigh, val); break;
-				default: assert(0);
-				}
+		odims[i] = 1;
 
-			} else {
+		if ((i != xdim) && (i != ydim))
+			off0 += pos[i] * (strs[i] / (long)sizeof(complex float));
+	}
+
+	odims[xdim] = (dims[xdim] + fx - 1) / fx;
+	odims[ydim] = (dims[ydim] + fy - 1) / fy;
+
+	long sx = strs[xdim] / (long)sizeof(complex float);
+	long sy = strs[ydim] / (long)sizeof(complex float);
+
+	// the output is in memory order of xdim and ydim
+	long ox = (xdim < ydim) ? 1 : odims[ydim];
+	long oy = (xdim < ydim) ? odims[xdim] : 1;
+
+	in += off0;
+
+#pragma omp parallel for collapse(2)
+	for (long y = 0; y < odims[ydim]; y++) {
+		for (long x = 0; x < odims[xdim]; x++) {
+
+			complex float sum = 0.;
+			int n = 0;
 
-				rgb[0] = 0.;
-				rgb[1] = 0.;
-				rgb[2] = 0.;
+			for (long j = y * fy; j < MIN(dims[ydim], (y + 1) * fy); j++) {
+				for (long i = x * fx; i < MIN(dims[xdim], (x + 1) * fx); i++) {
+
+					complex float v = in[j * sy + i * sx];
+
+					sum += mag ? cabsf(v) : v;
+					n++;
+				}
 			}
 
-			(*rgbbuf)[y][x][0] = 255. * rgb[2];
-			(*rgbbuf)[y][x][1] = 255. * rgb[1];
-			(*rgbbuf)[y][x][2] = 255. * rgb[0];
-			(*rgbbuf)[y][x][3] = 255.;
+			out[y * oy + x * ox] = sum / n;
 		}
 	}
 }
 
 
-void update_buf(long xdim, long ydim, int N, const long dims[N], const long strs[N], const long pos[N],
-		enum flip_t flip, enum interp_t interpolation, double xzoom, double yzoom, bool plot,
-		long rgbw, long rgbh, const complex float* data, complex float* buf)
+// position of pixel (x0, y0) of the zoomed image and steps along x and y
+static void buf_geometry(long xdim, long ydim, int N, const long dims[N], const long pos[N],
+		enum flip_t flip, double xzoom, double yzoom, bool plot,
+		long x0, long y0, double dpos[N], double dx[N], double dy[N])
 {
-	if (plot)
-		rgbh = 1;
-
-	double dpos[N];
 	for (int i = 0; i < N; i++)
 		dpos[i] = pos[i];
 
@@ -401,11 +1249,9 @@ void update_buf(long xdim, long ydim, int N, const long dims[N], const long strs
 	if (!plot)
 		dpos[ydim] = 0.;
 
-	double dx[N];
 	for (int i = 0; i < N; i++)
 		dx[i] = 0.;
 
-	double dy[N];
 	for (int i = 0; i < N; i++)
 		dy[i] = 0.;
 
@@ -435,10 +1281,77 @@ void update_buf(long xdim, long ydim, int N, const long dims[N], const long strs
 	dx[xdim] = dx[xdim] / xzoom;
 	dy[ydim] = dy[ydim] / yzoom;
 
+	for (int i = 0; i < N; i++)
+		dpos[i] += x0 * dx[i] + y0 * dy[i];
+}
+
+// resample the rgbw x rgbh region at (x0, y0) of the zoomed image
+void update_buf_region(long xdim, long ydim, int N, const long dims[N], const long strs[N], const long pos[N],
+		enum flip_t flip, enum interp_t interpolation, double xzoom, double yzoom, bool plot,
+		long x0, long y0, long rgbw, long rgbh, const complex float* data, complex float* buf)
+{
+	if (plot)
+		rgbh = 1;
+
+	double dpos[N];
+	double dx[N];
+	double dy[N];
+
+	buf_geometry(xdim, ydim, N, dims, pos, flip, xzoom, yzoom, plot, x0, y0, dpos, dx, dy);
+
 	resample(rgbw, rgbh, rgbw, buf,
 		 N, dpos, dx, dy, dims, strs, interpolation, data);
 }
 
+// as update_buf_region() followed by draw(), without the intermediate buffer
+void update_draw_region(long xdim, long ydim, int N, const long dims[N], const long strs[N], const long pos[N],
+		enum flip_t flip, enum interp_t interpolation, double xzoom, double yzoom,
+		long x0, long y0, int rgbw, int rgbh, int rgbstr, unsigned char (*rgbbuf)[rgbh][rgbstr / 4][4],
+		enum mode_t mode, enum color_t ctab, float scale, float winlow, float winhigh, float phrot,
+		const complex float* data)
+{
+	double dpos[N];
+	double dx[N];
+	double dy[N];
+
+	buf_geometry(xdim, ydim, N, dims, pos, flip, xzoom, yzoom, false, x0, y0, dpos, dx, dy);
+
+	resample_draw(rgbw, rgbh, rgbstr, rgbbuf, mode, ctab, scale, winlow, winhigh, phrot,
+		 N, dpos, dx, dy, dims, strs, interpolation, data);
+}
+
+void update_buf(long xdim, long ydim, int N, const long dims[N], const long strs[N], const long pos[N],
+		enum flip_t flip, enum interp_t interpolation, double xzoom, double yzoom, bool plot,
+		long rgbw, long rgbh, const complex float* data, complex float* buf)
+{
+	update_buf_region(xdim, ydim, N, dims, strs, pos, flip, interpolation, xzoom, yzoom, plot,
+			0, 0, rgbw, rgbh, data, buf);
+}
+
+
+/* Nearest-neighbour interpolation with an integer zoom factor only
+ * replicates pixels, so we can sample and colormap once per input
+ * pixel and then replicate the RGB values.
+ */
+extern bool native_zoom(enum interp_t interpolation, double xzoom, double yzoom, bool plot)
+{
+	return    (NEAREST == interpolation) && !plot
+	       && (xzoom >= 1.) && (xzoom == round(xzoom))
+	       && (yzoom >= 1.) && (yzoom == round(yzoom));
+}
+
+extern void draw_replicate(int X, int Y, int rgbstr, unsigned char (*rgbbuf)[Y][rgbstr / 4][4], int x0, int y0,
+	int xzoom, int yzoom, int NX, int NY, int nstr, const unsigned char (*nbuf)[NY][nstr / 4][4])
+{
+	assert(x0 + X <= NX * xzoom);
+	assert(y0 + Y <= NY * yzoom);
+
+#pragma omp parallel for
+	for (int y = 0; y < Y; y++)
+		for (int x = 0; x < X; x++)
+			memcpy((*rgbbuf)[y][x], (*nbuf)[(y0 + y) / yzoom][(x0 + x) / xzoom], 4);
+}
+
 
 const char color_white[3] = { 255, 255, 255 };
 const char color_blue[3] = { 255, 0, 0 };
@@ -4,16 +4,32 @@
 
 #include "view.h"
 
+#ifndef TILE_SIZE
+#define TILE_SIZE 64
+#endif
+
+extern int tiles_count(int X, int Y);
+extern void tiles_mark(int X, int Y, bool* mask, int x0, int y0, int x1, int y1);
+
 extern complex float sample(int N, const float pos[N], const long dims[N], const long strs[N], enum interp_t interpolation, const complex float* in);
 
 extern void resample(int X, int Y, long str, complex float* buf,
 	int N, const double pos[N], const double dx[N], const double dy[N], 
 	const long dims[N], const long strs[N], enum interp_t interpolation, const complex float* in);
 
+extern void resample_draw(int X, int Y, int rgbstr, unsigned char (*rgbbuf)[Y][rgbstr / 4][4],
+	enum mode_t mode, enum color_t ctab, float scale, float winlow, float winhigh, float phrot,
+	int N, const double pos[N], const double dx[N], const double dy[N],
+	const long dims[N], const long strs[N], enum interp_t interpolation, const complex float* in);
+
 extern void draw(int X, int Y, int rgbstr, unsigned char (*rgbbuf)[Y][rgbstr / 4][4],
 	enum mode_t mode, enum color_t ctab, float scale, float winlow, float winhigh, float phrot,
 	long str, const complex float* buf);
 
+extern void draw_tiles(int X, int Y, int rgbstr, unsigned char (*rgbbuf)[Y][rgbstr / 4][4],
+	enum mode_t mode, enum color_t ctab, float scale, float winlow, float winhigh, float phrot,
+	long str, const complex float* buf, const bool* mask);
+
 extern void draw_plot(int X, int Y, int rgbstr, unsigned char (*rgbbuf)[Y][rgbstr / 4][4],
 	enum mode_t mode, enum color_t ctab, float scale, float winlow, float winhigh, float phrot,
 	long str, const complex float* buf);
@@ -22,6 +38,25 @@ extern void update_buf(long xdim, long ydim, int N, const long dims[N],  const l
 		enum flip_t flip, enum interp_t interpolation, double xzoom, double yzoom, bool plot,
 		long rgbw, long rgbh, const complex float* data, complex float* buf);
 
+extern void update_buf_region(long xdim, long ydim, int N, const long dims[N],  const long strs[N], const long pos[N],
+		enum flip_t flip, enum interp_t interpolation, double xzoom, double yzoom, bool plot,
+		long x0, long y0, long rgbw, long rgbh, const complex float* data, complex float* buf);
+
+extern void update_draw_region(long xdim, long ydim, int N, const long dims[N], const long strs[N], const long pos[N],
+		enum flip_t flip, enum interp_t interpolation, double xzoom, double yzoom,
+		long x0, long y0, int rgbw, int rgbh, int rgbstr, unsigned char (*rgbbuf)[rgbh][rgbstr / 4][4],
+		enum mode_t mode, enum color_t ctab, float scale, float winlow, float winhigh, float phrot,
+		const complex float* data);
+
+extern int reduce_factor(double zoom);
+extern void reduce_plane(long xdim, long ydim, int N, const long dims[N], const long strs[N], const long pos[N],
+	int fx, int fy, bool mag, long odims[N], complex float* out, const complex float* in);
+
+extern bool native_zoom(enum interp_t interpolation, double xzoom, double yzoom, bool plot);
+
+extern void draw_replicate(int X, int Y, int rgbstr, unsigned char (*rgbbuf)[Y][rgbstr / 4][4], int x0, int y0,
+	int xzoom, int yzoom, int NX, int NY, int nstr, const unsigned char (*nbuf)[NY][nstr / 4][4]);
+
 extern void draw_line(int X, int Y, int rgbstr, unsigned char (*rgbbuf)[Y][rgbstr / 4][4], float x0, float y0, float x1, float y1, const char (*color)[3]);
 extern void draw_grid(int X, int Y, int rgbstr, unsigned char (*rgbbuf)[Y][rgbstr / 4][4], const float (*coord)[4][2], int divs, const char (*color)[3]);
 
@@ -28,10 +28,36 @@ const char* viewer_gui =
 ;
 
 
+#define UI_SURFACES 3
+
 struct view_gtk_ui_s {
 
 	// UI
 	cairo_surface_t* source;
+	int source_x;
+	int source_y;
+
+	// surfaces wrapping the frame buffers of the view, reused while buffer and size stay the same
+	struct ui_surface_s {
+
+		cairo_surface_t* surface;
+		unsigned char* buf;
+		int w;
+		int h;
+		int str;
+
+	} surfaces[UI_SURFACES];
+
+	int surface_next;
+
+	int width;
+	int height;
+
+	// idle source redrawing after a frame was rendered
+	guint redraw_source;
+
+	// tick callback on the frame clock
+	guint tick_source;
 
 	// widgets
 	GtkComboBox* gtk_mode;
@@ -47,6 +73,7 @@ struct view_gtk_ui_s {
 	GtkToolItem* toolbar_scale2;
 	GtkToolItem* toolbar_button1;
 	GtkToolItem* toolbar_button2;
+	GtkWidget* gtk_histogram;
 	GtkAdjustment* gtk_zoom;
 	GtkAdjustment* gtk_aniso;
 	GtkEntry* gtk_entry;
@@ -54,6 +81,10 @@ struct view_gtk_ui_s {
 	GtkToggleToolButton* gtk_fit;
 	GtkToggleToolButton* gtk_sync;
 	GtkToggleToolButton* gtk_absolutewindowing;
+	GtkToggleToolButton* gtk_pause;
+	GtkToggleToolButton* gtk_cine;
+	GtkAdjustment* gtk_cine_dim;
+	GtkAdjustment* gtk_cine_fps;
 
 	GtkAdjustment* gtk_posall[DIMS];
 	GtkCheckButton* gtk_checkall[DIMS];
@@ -146,6 +177,63 @@ extern gboolean window_callback(GtkWidget* /*widget*/, gpointer data)
 	return FALSE;
 }
 
+extern gboolean autowindow_callback(GtkWidget* /*widget*/, gpointer data)
+{
+	struct view_s* v = data;
+
+	if (!view_acquire(v, true))
+		return FALSE;
+
+	view_auto_window(v, 0.01, 0.99);
+
+	view_release(v);
+
+	return FALSE;
+}
+
+extern gboolean histogram_draw_callback(GtkWidget* widget, cairo_t *cr, gpointer data)
+{
+	struct view_s* v = data;
+
+	int w = gtk_widget_get_allocated_width(widget);
+	int h = gtk_widget_get_allocated_height(widget);
+
+	if (0 >= w)
+		return FALSE;
+
+	float bins[w];
+	double low;
+	double high;
+
+	view_acquire(v, true);
+
+	bool ok = view_histogram(v, w, bins, &low, &high);
+
+	view_release(v);
+
+	if (!ok)
+		return FALSE;
+
+	cairo_set_source_rgb(cr, 0.5, 0.5, 0.5);
+
+	for (int x = 0; x < w; x++)
+		cairo_rectangle(cr, x, h * (1. - bins[x]), 1., h * bins[x]);
+
+	cairo_fill(cr);
+
+	cairo_set_source_rgb(cr, 1., 0., 0.);
+	cairo_set_line_width(cr, 1.);
+
+	cairo_move_to(cr, w * low, 0.);
+	cairo_line_to(cr, w * low, h);
+	cairo_move_to(cr, w * high, 0.);
+	cairo_line_to(cr, w * high, h);
+
+	cairo_stroke(cr);
+
+	return FALSE;
+}
+
 extern gboolean save_callback(GtkWidget* /*widget*/, gpointer data)
 {
 	struct view_s* v = data;
@@ -295,6 +383,12 @@ extern gboolean window_close_callback(GtkWidget* /*widget*/, GdkEvent* /*event*/
 
 	view_window_close(v);
 
+	if (0 != v->ui->redraw_source)
+		g_source_remove(v->ui->redraw_source);
+
+	if (0 != v->ui->tick_source)
+		gtk_widget_remove_tick_callback(v->ui->gtk_drawingarea, v->ui->tick_source);
+
 	return FALSE;
 }
 
@@ -314,8 +408,12 @@ extern gboolean draw_callback(GtkWidget* /*widget*/, cairo_t *cr, gpointer data)
 
 	view_draw(v);
 
-	cairo_set_source_surface(cr, v->ui->source, 0, 0);
-	cairo_paint(cr);
+	// nothing rendered yet
+	if (NULL != v->ui->source) {
+
+		cairo_set_source_surface(cr, v->ui->source, v->ui->source_x, v->ui->source_y);
+		cairo_paint(cr);
+	}
 
 	view_release(v);
 
@@ -364,6 +462,38 @@ extern gboolean toogle_absolute_windowing_callback(GtkToggleToolButton* button,
 	return FALSE;
 }
 
+extern gboolean toggle_pause_callback(GtkToggleToolButton* button, gpointer data)
+{
+	struct view_s* v = data;
+
+	if (!view_acquire(v, true))
+		return FALSE;
+
+	view_pause(v, (TRUE == gtk_toggle_tool_button_get_active(button)));
+
+	view_release(v);
+
+	return FALSE;
+}
+
+extern gboolean cine_callback(GtkWidget* /*widget*/, gpointer data)
+{
+	struct view_s* v = data;
+
+	if (!view_acquire(v, true))
+		return FALSE;
+
+	bool play = gtk_toggle_tool_button_get_active(v->ui->gtk_cine);
+	int dim = gtk_adjustment_get_value(v->ui->gtk_cine_dim);
+	double fps = gtk_adjustment_get_value(v->ui->gtk_cine_fps);
+
+	view_cine(v, dim, play ? fps : 0.);
+
+	view_release(v);
+
+	return FALSE;
+}
+
 static gboolean io_callback(GIOChannel * /* gio_channel */, GIOCondition giocondition, gpointer data)
 {
 	struct io_callback_data* cb = data;
@@ -393,19 +523,128 @@ extern void ui_configure(struct view_s *v)
 void ui_trigger_redraw(struct view_s* v)
 {
 	gtk_widget_queue_draw(v->ui->gtk_drawingarea);
+
+	// drawn from cached bins
+	gtk_widget_queue_draw(v->ui->gtk_histogram);
 }
 
 void ui_rgbbuffer_disconnect(struct view_s* v)
 {
-	if (NULL != v->ui->source)
-		cairo_surface_destroy(v->ui->source);
+	for (int i = 0; i < UI_SURFACES; i++) {
+
+		if (NULL != v->ui->surfaces[i].surface)
+			cairo_surface_destroy(v->ui->surfaces[i].surface);
+
+		v->ui->surfaces[i].surface = NULL;
+		v->ui->surfaces[i].buf = NULL;
+	}
+
+	v->ui->source = NULL;
 }
 
-void ui_rgbbuffer_connect(struct view_s* v, int rgbw, int rgbh, int rgbstr, unsigned char *buf)
+void ui_rgbbuffer_connect(struct view_s* v, int x, int y, int rgbw, int rgbh, int rgbstr, unsigned char *buf)
 {
-	gtk_widget_set_size_request(v->ui->gtk_drawingarea, rgbw, rgbh);
+	v->ui->source_x = x;
+	v->ui->source_y = y;
+
+	for (int i = 0; i < UI_SURFACES; i++) {
+
+		struct ui_surface_s* s = &v->ui->surfaces[i];
+
+		if ((buf == s->buf) && (rgbw == s->w) && (rgbh == s->h) && (rgbstr == s->str)) {
+
+			// the buffer holds a new frame
+			cairo_surface_mark_dirty(s->surface);
+
+			v->ui->source = s->surface;
+			return;
+		}
+	}
+
+	struct ui_surface_s* s = &v->ui->surfaces[v->ui->surface_next];
+
+	v->ui->surface_next = (v->ui->surface_next + 1) % UI_SURFACES;
+
+	if (NULL != s->surface)
+		cairo_surface_destroy(s->surface);
+
+	s->surface = cairo_image_surface_create_for_data(buf, CAIRO_FORMAT_RGB24, rgbw, rgbh, rgbstr);
+	s->buf = buf;
+	s->w = rgbw;
+	s->h = rgbh;
+	s->str = rgbstr;
+
+	v->ui->source = s->surface;
+}
+
+void ui_set_size(struct view_s* v, int width, int height)
+{
+	if ((width == v->ui->width) && (height == v->ui->height))
+		return;
+
+	gtk_widget_set_size_request(v->ui->gtk_drawingarea, width, height);
+
+	v->ui->width = width;
+	v->ui->height = height;
+}
+
+// visible part of the drawing area
+void ui_get_viewport(struct view_s* v, int* x, int* y, int* w, int* h)
+{
+	GtkScrolledWindow* sw = GTK_SCROLLED_WINDOW(v->ui->gtk_viewport);
+
+	GtkAdjustment* hadj = gtk_scrolled_window_get_hadjustment(sw);
+	GtkAdjustment* vadj = gtk_scrolled_window_get_vadjustment(sw);
 
-	v->ui->source = cairo_image_surface_create_for_data(buf, CAIRO_FORMAT_RGB24, rgbw, rgbh, rgbstr);
+	*x = gtk_adjustment_get_value(hadj);
+	*y = gtk_adjustment_get_value(vadj);
+	*w = gtk_adjustment_get_page_size(hadj);
+	*h = gtk_adjustment_get_page_size(vadj);
+}
+
+static gboolean frame_ready_callback(gpointer data)
+{
+	struct view_s* v = data;
+
+	view_acquire(v, true);
+
+	v->ui->redraw_source = 0;
+	ui_trigger_redraw(v);
+
+	view_release(v);
+
+	return G_SOURCE_REMOVE;
+}
+
+// called from the render thread with the view locked
+void ui_frame_ready(struct view_s* v)
+{
+	if (0 == v->ui->redraw_source)
+		v->ui->redraw_source = g_idle_add_full(G_PRIORITY_HIGH_IDLE, frame_ready_callback, v, NULL);
+}
+
+static gboolean tick_callback(GtkWidget* /*widget*/, GdkFrameClock* /*clock*/, gpointer data)
+{
+	struct view_s* v = data;
+
+	v->ui->tick_source = 0;
+
+	view_tick(v);
+
+	return G_SOURCE_REMOVE;
+}
+
+// call view_tick() before the next frame is drawn
+void ui_request_tick(struct view_s* v)
+{
+	if (0 == v->ui->tick_source)
+		v->ui->tick_source = gtk_widget_add_tick_callback(v->ui->gtk_drawingarea, tick_callback, v, NULL);
+}
+
+// controls which only make sense for streams
+void ui_set_realtime(struct view_s* v)
+{
+	gtk_widget_set_visible(GTK_WIDGET(v->ui->gtk_pause), TRUE);
 }
 
 void ui_set_msg(struct view_s* v, const char* msg)
@@ -421,6 +660,17 @@ void ui_window_new(struct view_s* v, int N, const long dims[N], const struct vie
 		v->ui_params.selected[i] = (i == settings.xdim || i == settings.ydim);
 
 	v->ui->source = NULL;
+	v->ui->source_x = 0;
+	v->ui->source_y = 0;
+
+	for (int i = 0; i < UI_SURFACES; i++)
+		v->ui->surfaces[i] = (struct ui_surface_s){ .surface = NULL, .buf = NULL };
+
+	v->ui->surface_next = 0;
+	v->ui->width = -1;
+	v->ui->height = -1;
+	v->ui->redraw_source = 0;
+	v->ui->tick_source = 0;
 
 	GtkBuilder* builder = gtk_builder_new();
 	gtk_builder_add_from_string(builder, viewer_gui, -1, NULL);
@@ -461,9 +711,22 @@ void ui_window_new(struct view_s* v, int N, const long dims[N], const struct vie
 	v->ui->toolbar_button1 = GTK_TOOL_ITEM(gtk_builder_get_object(builder, "toolbar_button1"));
 	v->ui->toolbar_button2 = GTK_TOOL_ITEM(gtk_builder_get_object(builder, "toolbar_button2"));
 
+	v->ui->gtk_histogram = GTK_WIDGET(gtk_builder_get_object(builder, "histogram"));
+
 	v->ui->gtk_absolutewindowing = GTK_TOGGLE_TOOL_BUTTON(gtk_builder_get_object(builder, "abswindow"));
 	gtk_toggle_tool_button_set_active(v->ui->gtk_absolutewindowing, settings.absolute_windowing ? TRUE : FALSE);
 
+	v->ui->gtk_pause = GTK_TOGGLE_TOOL_BUTTON(gtk_builder_get_object(builder, "pause"));
+
+	v->ui->gtk_cine = GTK_TOGGLE_TOOL_BUTTON(gtk_builder_get_object(builder, "cine"));
+	v->ui->gtk_cine_dim = GTK_ADJUSTMENT(gtk_builder_get_object(builder, "cine_dim"));
+	v->ui->gtk_cine_fps = GTK_ADJUSTMENT(gtk_builder_get_object(builder, "cine_fps"));
+
+	// the last dimension which is not shown in the image
+	for (int j = 0; j < DIMS; j++)
+		if ((1 < dims[j]) && (j != settings.xdim) && (j != settings.ydim))
+			gtk_adjustment_set_value(v->ui->gtk_cine_dim, j);
+
 	for (int j = 0; j < DIMS; j++) {
 
 		char pname[10];
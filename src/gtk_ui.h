@@ -14,7 +14,9 @@ struct io_callback_data {
 };
 
 extern void ui_rgbbuffer_disconnect(struct view_s* v);
-extern void ui_rgbbuffer_connect(struct view_s* v, int rgbw, int rgbh, int rgbstr, unsigned char* buf);
+extern void ui_rgbbuffer_connect(struct view_s* v, int x, int y, int rgbw, int rgbh, int rgbstr, unsigned char* buf);
+extern void ui_set_size(struct view_s* v, int width, int height);
+extern void ui_get_viewport(struct view_s* v, int* x, int* y, int* w, int* h);
 
 void ui_set_params(struct view_s* v, struct view_ui_params_s params, struct view_settings_s img_params);
 
@@ -28,6 +30,9 @@ extern void ui_loop_quit();
 
 extern void ui_configure(struct view_s* v);
 extern void ui_trigger_redraw(struct view_s* v);
+extern void ui_frame_ready(struct view_s* v);
+extern void ui_request_tick(struct view_s* v);
+extern void ui_set_realtime(struct view_s* v);
 
 void ui_add_io_callback(int fd, struct io_callback_data* cb);
 
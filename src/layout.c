@@ -0,0 +1,341 @@
+/* Copyright 2026. TU Graz. Institute of Biomedical Imaging.
+ * All rights reserved. Use of this source code is governed by
+ * a BSD-style license which can be found in the LICENSE file.
+ */
+
+#include <complex.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <threads.h>
+
+#include "num/multind.h"
+
+#include "misc/misc.h"
+
+#include "layout.h"
+
+
+// elements copied between checks for another request
+#define LAYOUT_BATCH (8l << 20)
+
+// planes copied together, so that the cache lines read are used completely
+#define LAYOUT_GROUP 8
+
+struct layout_s {
+
+	int N;
+	long* dims;
+	long* strs;	// in elements
+	const complex float* data;
+
+	long size;
+
+	// copy of the data with the dims of a plane innermost
+	complex float* copy;
+	bool failed;
+
+	mtx_t mx;
+	cnd_t cnd;
+	thrd_t thread;
+	bool quit;
+
+	// plane requested last and the plane in the copy
+	int want[2];
+	int have[2];
+	bool ready;
+
+	// a copy has been completed, called from the helper thread
+	void (*notify)(void* arg);
+	void* arg;
+	bool fresh;
+};
+
+
+// planes along xdim and ydim are contiguous without a copy
+static bool plane_contiguous(const struct layout_s* l, int xdim, int ydim)
+{
+	for (int i = 0; i < MAX(xdim, ydim); i++)
+		if ((i != xdim) && (i != ydim) && (1 != l->dims[i]))
+			return false;
+
+	return true;
+}
+
+// strides of the copy, xdim first, then ydim and the other dims in order
+static void copy_strides(const struct layout_s* l, int xdim, int ydim, long strs[])
+{
+	strs[xdim] = 1;
+	strs[ydim] = l->dims[xdim];
+
+	long s = l->dims[xdim] * l->dims[ydim];
+
+	for (int i = 0; i < l->N; i++) {
+
+		if ((i == xdim) || (i == ydim))
+			continue;
+
+		strs[i] = s;
+		s *= l->dims[i];
+	}
+}
+
+static bool layout_wanted(struct layout_s* l, int xdim, int ydim)
+{
+	mtx_lock(&l->mx);
+	bool r = !l->quit && (xdim == l->want[0]) && (ydim == l->want[1]);
+	mtx_unlock(&l->mx);
+
+	return r;
+}
+
+// false if another plane was requested meanwhile
+static bool layout_copy(struct layout_s* l, int xdim, int ydim)
+{
+	int N = l->N;
+
+	long ostrs[N];
+	copy_strides(l, xdim, ydim, ostrs);
+
+	long nx = l->dims[xdim];
+	long ny = l->dims[ydim];
+	long sx = l->strs[xdim];
+	long sy = l->strs[ydim];
+
+	// planes are copied in groups along the first other dim
+	int d0 = -1;
+
+	for (int i = 0; i < N; i++)
+		if ((i != xdim) && (i != ydim) && (1 < l->dims[i]) && (-1 == d0))
+			d0 = i;
+
+	long n0 = (-1 == d0) ? 1 : l->dims[d0];
+	long is0 = (-1 == d0) ? 0 : l->strs[d0];
+	long os0 = (-1 == d0) ? 0 : ostrs[d0];
+
+	long rows = l->size / (nx * ny * n0);
+	long batch = MAX(1, LAYOUT_BATCH / (nx * ny * n0));
+
+	for (long r0 = 0; r0 < rows; r0 += batch) {
+
+		if (!layout_wanted(l, xdim, ydim))
+			return false;
+
+		long r1 = MIN(rows, r0 + batch);
+
+#pragma omp parallel for
+		for (long r = r0; r < r1; r++) {
+
+			long ioff = 0;
+			long ooff = 0;
+			long k = r;
+
+			for (int i = 0; i < N; i++) {
+
+				if ((i == xdim) || (i == ydim) || (i == d0))
+					continue;
+
+				ioff += (k % l->dims[i]) * l->strs[i];
+				ooff += (k % l->dims[i]) * ostrs[i];
+				k /= l->dims[i];
+			}
+
+			for (long j0 = 0; j0 < n0; j0 += LAYOUT_GROUP) {
+
+				long jn = MIN(LAYOUT_GROUP, n0 - j0);
+
+				const complex float* in = l->data + ioff + j0 * is0;
+				complex float* out = l->copy + ooff + j0 * os0;
+
+				for (long y = 0; y < ny; y++)
+					for (long x = 0; x < nx; x++)
+						for (long j = 0; j < jn; j++)
+							out[j * os0 + y * nx + x] = in[j * is0 + y * sy + x * sx];
+			}
+		}
+	}
+
+	return true;
+}
+
+static int layout_thread(void* _l)
+{
+	struct layout_s* l = _l;
+
+	mtx_lock(&l->mx);
+
+	while (!l->quit) {
+
+		if (l->ready || l->failed || (-1 == l->want[0])) {
+
+			cnd_wait(&l->cnd, &l->mx);
+			continue;
+		}
+
+		int xdim = l->want[0];
+		int ydim = l->want[1];
+
+		mtx_unlock(&l->mx);
+
+		if (NULL == l->copy)
+			l->copy = malloc((size_t)l->size * sizeof(complex float));
+
+		bool done = (NULL != l->copy) && layout_copy(l, xdim, ydim);
+
+		mtx_lock(&l->mx);
+
+		if (NULL == l->copy)
+			l->failed = true;
+
+		if (done && (xdim == l->want[0]) && (ydim == l->want[1])) {
+
+			l->have[0] = xdim;
+			l->have[1] = ydim;
+			l->ready = true;
+			l->fresh = true;
+
+			mtx_unlock(&l->mx);
+
+			l->notify(l->arg);
+
+			mtx_lock(&l->mx);
+		}
+	}
+
+	mtx_unlock(&l->mx);
+
+	return 0;
+}
+
+
+static void free_layout(struct layout_s* l)
+{
+	free(l->copy);
+	xfree(l->dims);
+	xfree(l->strs);
+	xfree(l);
+}
+
+// copies of data for planes which are not contiguous, built on a helper thread, NULL if it cannot be started.
+// notify is called from the helper thread when a copy has been completed.
+struct layout_s* create_layout(int N, const long dims[N], const complex float* data, void (*notify)(void* arg), void* arg)
+{
+	struct layout_s* l = xmalloc(sizeof(struct layout_s));
+
+	l->N = N;
+	l->dims = xmalloc(N * sizeof(long));
+	l->strs = xmalloc(N * sizeof(long));
+	l->data = data;
+
+	md_copy_dims(N, l->dims, dims);
+	md_calc_strides(N, l->strs, dims, 1);
+
+	l->size = md_calc_size(N, dims);
+
+	l->copy = NULL;
+	l->failed = false;
+	l->quit = false;
+	l->want[0] = -1;
+	l->want[1] = -1;
+	l->have[0] = -1;
+	l->have[1] = -1;
+	l->ready = false;
+	l->notify = notify;
+	l->arg = arg;
+	l->fresh = false;
+
+	mtx_init(&l->mx, mtx_plain);
+	cnd_init(&l->cnd);
+
+	if (thrd_success != thrd_create(&l->thread, layout_thread, l)) {
+
+		cnd_destroy(&l->cnd);
+		mtx_destroy(&l->mx);
+		free_layout(l);
+
+		return NULL;
+	}
+
+	return l;
+}
+
+void delete_layout(struct layout_s* l)
+{
+	if (NULL == l)
+		return;
+
+	mtx_lock(&l->mx);
+	l->quit = true;
+	cnd_broadcast(&l->cnd);
+	mtx_unlock(&l->mx);
+
+	thrd_join(l->thread, NULL);
+
+	cnd_destroy(&l->cnd);
+	mtx_destroy(&l->mx);
+	free_layout(l);
+}
+
+// data and strides (in bytes) with xdim and ydim innermost, or NULL while the copy is built or not needed.
+// a copy returned before must not be used anymore after a request for another plane.
+const complex float* layout_plane(struct layout_s* l, int xdim, int ydim, long strs[])
+{
+	if (NULL == l)
+		return NULL;
+
+	mtx_lock(&l->mx);
+
+	// a copy which is built is not needed anymore
+	if (plane_contiguous(l, xdim, ydim)) {
+
+		if (!l->ready) {
+
+			l->want[0] = -1;
+			l->want[1] = -1;
+		}
+
+		mtx_unlock(&l->mx);
+
+		return NULL;
+	}
+
+	const complex float* r = NULL;
+
+	if (l->ready && (xdim == l->have[0]) && (ydim == l->have[1])) {
+
+		copy_strides(l, xdim, ydim, strs);
+
+		for (int i = 0; i < l->N; i++)
+			strs[i] *= (long)sizeof(complex float);
+
+		r = l->copy;
+
+	} else if ((xdim != l->want[0]) || (ydim != l->want[1])) {
+
+		l->want[0] = xdim;
+		l->want[1] = ydim;
+		l->ready = false;
+
+		cnd_signal(&l->cnd);
+	}
+
+	mtx_unlock(&l->mx);
+
+	return r;
+}
+
+// true once after a copy has been completed
+bool layout_poll(struct layout_s* l)
+{
+	if (NULL == l)
+		return false;
+
+	mtx_lock(&l->mx);
+
+	bool r = l->fresh;
+	l->fresh = false;
+
+	mtx_unlock(&l->mx);
+
+	return r;
+}
+
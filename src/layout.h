@@ -0,0 +1,17 @@
+#ifndef VIEW_LAYOUT_H
+#define VIEW_LAYOUT_H
+
+#include <complex.h>
+#include <stdbool.h>
+
+
+struct layout_s;
+
+extern struct layout_s* create_layout(int N, const long dims[N], const complex float* data, void (*notify)(void* arg), void* arg);
+extern void delete_layout(struct layout_s* l);
+
+extern const complex float* layout_plane(struct layout_s* l, int xdim, int ydim, long strs[]);
+extern bool layout_poll(struct layout_s* l);
+
+#endif // VIEW_LAYOUT_H
+
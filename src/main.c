@@ -51,11 +51,21 @@ int main(int argc, char* argv[argc])
 	};
 
 	bool absolute_windowing = false;
+	bool stats_cache = false;
+	long history = -1;
+	bool history_buf = false;
+	bool layout = false;
+	long resident = 0;
 	enum color_t ctab = NONE;;
 
 	const struct opt_s opts[] = {
 
 		OPT_SET('a', &absolute_windowing, "Use absolute windowing"),
+		OPTL_SET(0, "stats-cache", &stats_cache, "Keep statistics in <image>.stats"),
+		OPTL_LONG(0, "history", &history, "MB", "Keep recently shown frames in MB (default: 256 for realtime input, otherwise 0)"),
+		OPTL_SET(0, "history-buf", &history_buf, "Also keep their interpolated images, for changes of the windowing"),
+		OPTL_SET(0, "layout-copy", &layout, "Copy the data for shown planes which are not contiguous, e.g. z-t"),
+		OPTL_LONG(0, "resident", &resident, "MB", "Out-of-core: keep about MB of the data in memory, statistics only of shown slices until refresh"),
 		OPT_SELECT('V', enum color_t, &ctab, VIRIDIS, "viridis"),
 		OPT_SELECT('Y', enum color_t, &ctab, MYGBM, "MYGBM"),
 		OPT_SELECT('T', enum color_t, &ctab, TURBO, "turbo"),
@@ -121,7 +131,13 @@ int main(int argc, char* argv[argc])
 		}
 #endif
 		// FIXME: we never delete them
-		struct view_s* v2 = window_new(in_files[i], pos, dims, x, absolute_windowing, ctab, realtime);
+		struct view_s* v2 = window_new(in_files[i], pos, dims, x, absolute_windowing, ctab, realtime, stats_cache, resident << 20);
+
+		// scrubbing back in a stream is common, otherwise the memory is spent only if asked for
+		long hist = (0 <= history) ? history : ((0 <= realtime) ? 256 : 0);
+
+		view_set_history(v2, hist << 20, history_buf);
+		view_set_layout(v2, layout);
 
 		// If multiple files are passed on the commandline, add them to window
 		// list. This enables sync of windowing and so on...
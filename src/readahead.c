@@ -0,0 +1,623 @@
+/* Copyright 2026. TU Graz. Institute of Biomedical Imaging.
+ * All rights reserved. Use of this source code is governed by
+ * a BSD-style license which can be found in the LICENSE file.
+ */
+
+#define _GNU_SOURCE
+#include <complex.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <threads.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "num/multind.h"
+
+#include "misc/misc.h"
+
+#include "readahead.h"
+
+
+// slices read ahead in the direction of scrolling and behind
+#ifndef READAHEAD_AHEAD
+#define READAHEAD_AHEAD 8
+#endif
+
+#ifndef READAHEAD_BEHIND
+#define READAHEAD_BEHIND 2
+#endif
+
+// slices which were read ahead are released further away
+#ifndef READAHEAD_FAR
+#define READAHEAD_FAR 32
+#endif
+
+#define READAHEAD_SLICES 64
+
+// parts of a slice closer than this are hinted together
+#define READAHEAD_GAP (64l << 10)
+
+#define READAHEAD_WINDOW (128l << 10)
+
+enum hint_t { HINT_NONE, HINT_WILLNEED, HINT_TOUCH, HINT_COLD, HINT_RELEASE, HINT_KEEP };
+
+// pages from a0 on which are kept by readahead_release()
+struct keep_s {
+
+	uintptr_t a0;
+	long n;
+	bool* keep;
+};
+
+struct readahead_s {
+
+	int N;
+	long* dims;
+	long* strs;	// in bytes
+	const complex float* data;
+	long size;	// in bytes
+
+	long page;
+
+	mtx_t mx;
+	cnd_t cnd;
+	thrd_t thread;
+	bool quit;
+
+	// latest position, only the last request is handled
+	bool request;
+	unsigned long flags;
+	long* pos;
+
+	// resident memory in bytes, slices are paged out beyond it, 0 for no limit
+	long budget;
+
+	// owned by the helper thread, the slices are also read by readahead_release() under slices_mx
+	mtx_t slices_mx;
+	struct keep_s* keep;
+
+	bool first;
+	long* last;
+	int dim;
+	int dir;
+
+	// slices read ahead or shown, least recently used first
+	int nslices;
+	unsigned long slice_flags[READAHEAD_SLICES];
+	long* slice_pos[READAHEAD_SLICES];
+	long slice_bytes[READAHEAD_SLICES];
+	long resident;
+
+	struct readahead_s* next;
+};
+
+// all helpers, for readahead_release()
+static once_flag readahead_once = ONCE_FLAG_INIT;
+static mtx_t readahead_mx;
+static struct readahead_s* readahead_list = NULL;
+
+static void readahead_init(void)
+{
+	mtx_init(&readahead_mx, mtx_plain);
+}
+
+
+static void page_out(void* p, long len)
+{
+#ifdef MADV_PAGEOUT
+	// also for anonymous memory, which is swapped out instead of discarded
+	madvise(p, len, MADV_PAGEOUT);
+#else
+	posix_madvise(p, len, POSIX_MADV_DONTNEED);
+#endif
+}
+
+
+// returns the size of the pages in the range
+static long advise_range(struct readahead_s* ra, long start, long end, enum hint_t hint)
+{
+	uintptr_t a0 = (uintptr_t)ra->data + start;
+	uintptr_t a1 = (uintptr_t)ra->data + end;
+
+	a0 -= a0 % ra->page;
+
+	char* p = (char*)a0;
+	long len = a1 - a0;
+
+	switch (hint) {
+
+	case HINT_NONE:
+
+		break;
+
+	case HINT_WILLNEED:
+
+		// the kernel reads at most about its readahead window per hint
+		for (long i = 0; i < len; i += READAHEAD_WINDOW)
+			posix_madvise(p + i, MIN(READAHEAD_WINDOW, len - i), POSIX_MADV_WILLNEED);
+
+		break;
+
+	case HINT_TOUCH:
+
+		// fault the pages in here and not in the render thread
+		for (long i = 0; i < len; i += ra->page)
+			(void)*(volatile const char*)(p + i);
+
+		break;
+
+	case HINT_COLD:
+
+#ifdef MADV_COLD
+		// MADV_DONTNEED would discard anonymous memory, e.g. of in-memory inputs
+		madvise(p, len, MADV_COLD);
+#else
+		posix_madvise(p, len, POSIX_MADV_DONTNEED);
+#endif
+		break;
+
+	case HINT_RELEASE:
+
+		page_out(p, len);
+		break;
+
+	case HINT_KEEP:
+
+		for (long i = (a0 < ra->keep->a0) ? 0 : (long)(a0 - ra->keep->a0) / ra->page;
+		     (i < ra->keep->n) && (ra->keep->a0 + i * ra->page < a1); i++)
+			ra->keep->keep[i] = true;
+
+		break;
+	}
+
+	return (len + ra->page - 1) / ra->page * ra->page;
+}
+
+// the slice at pos extends along the dims in flags, it is hinted in contiguous parts, returns the size of its pages
+static long advise_slice(struct readahead_s* ra, unsigned long flags, const long pos[], enum hint_t hint)
+{
+	int N = ra->N;
+
+	long offset = 0;
+
+	for (int i = 0; i < N; i++)
+		if (!MD_IS_SET(flags, i))
+			offset += pos[i] * ra->strs[i];
+
+	long block = (long)sizeof(complex float);
+	int d = 0;
+
+	while ((d < N) && (MD_IS_SET(flags, d) || (1 == ra->dims[d])))
+		block *= ra->dims[d++];
+
+	long count = 1;
+
+	for (int i = d; i < N; i++)
+		if (MD_IS_SET(flags, i))
+			count *= ra->dims[i];
+
+	long gap = ((HINT_TOUCH == hint) || (HINT_KEEP == hint)) ? ra->page : READAHEAD_GAP;
+
+	long start = -1;
+	long end = -1;
+	long bytes = 0;
+
+	for (long k = 0; k < count; k++) {
+
+		long o = offset;
+		long r = k;
+
+		for (int i = d; i < N; i++) {
+
+			if (!MD_IS_SET(flags, i))
+				continue;
+
+			o += (r % ra->dims[i]) * ra->strs[i];
+			r /= ra->dims[i];
+		}
+
+		if ((0 <= start) && (o <= end + gap)) {
+
+			end = o + block;
+			continue;
+		}
+
+		if (0 <= start)
+			bytes += advise_range(ra, start, end, hint);
+
+		start = o;
+		end = o + block;
+	}
+
+	return bytes + advise_range(ra, start, end, hint);
+}
+
+static int find_slice(struct readahead_s* ra, unsigned long flags, const long pos[])
+{
+	for (int i = 0; i < ra->nslices; i++)
+		if ((flags == ra->slice_flags[i]) && md_check_equal_dims(ra->N, pos, ra->slice_pos[i], ~flags))
+			return i;
+
+	return -1;
+}
+
+static void remove_slice(struct readahead_s* ra, int i)
+{
+	long* p = ra->slice_pos[i];
+
+	ra->resident -= ra->slice_bytes[i];
+
+	for (int j = i; j < ra->nslices - 1; j++) {
+
+		ra->slice_flags[j] = ra->slice_flags[j + 1];
+		ra->slice_pos[j] = ra->slice_pos[j + 1];
+		ra->slice_bytes[j] = ra->slice_bytes[j + 1];
+	}
+
+	ra->nslices--;
+	ra->slice_pos[ra->nslices] = p;
+}
+
+// with a budget, slices are paged out when they are forgotten
+static void release_slice(struct readahead_s* ra, long budget, int i, enum hint_t hint)
+{
+	advise_slice(ra, ra->slice_flags[i], ra->slice_pos[i], (0 < budget) ? HINT_RELEASE : hint);
+	remove_slice(ra, i);
+}
+
+static void add_slice(struct readahead_s* ra, long budget, unsigned long flags, const long pos[], long bytes)
+{
+	if (READAHEAD_SLICES == ra->nslices)
+		release_slice(ra, budget, 0, HINT_NONE);
+
+	ra->slice_flags[ra->nslices] = flags;
+	md_copy_dims(ra->N, ra->slice_pos[ra->nslices], pos);
+	ra->slice_bytes[ra->nslices] = bytes;
+	ra->resident += bytes;
+	ra->nslices++;
+}
+
+// slices read ahead which are far away now
+static void release_slices(struct readahead_s* ra, long budget, unsigned long flags, const long pos[])
+{
+	for (int i = ra->nslices - 1; 0 <= i; i--) {
+
+		// another plane, which may overlap with the current one
+		if (flags != ra->slice_flags[i]) {
+
+			release_slice(ra, budget, i, HINT_NONE);
+			continue;
+		}
+
+		long dist = 0;
+
+		for (int j = 0; j < ra->N; j++)
+			if (!MD_IS_SET(flags, j))
+				dist += labs(pos[j] - ra->slice_pos[i][j]);
+
+		if (READAHEAD_FAR < dist)
+			release_slice(ra, budget, i, HINT_COLD);
+	}
+}
+
+// with a budget, the shown slice becomes the most recently used one
+static void shown_slice(struct readahead_s* ra, long budget, unsigned long flags, const long pos[])
+{
+	if (0 == budget)
+		return;
+
+	int i = find_slice(ra, flags, pos);
+	long bytes = (-1 == i) ? advise_slice(ra, flags, pos, HINT_NONE) : ra->slice_bytes[i];
+
+	if (-1 != i)
+		remove_slice(ra, i);
+
+	add_slice(ra, budget, flags, pos, bytes);
+
+	// least recently used slices are paged out, the shown one is kept
+	while ((budget < ra->resident) && (1 < ra->nslices))
+		release_slice(ra, budget, 0, HINT_NONE);
+}
+
+static void readahead_update(struct readahead_s* ra, long budget, unsigned long flags, const long pos[])
+{
+	int N = ra->N;
+
+	// follow the dimension which changed last
+	if (!ra->first) {
+
+		for (int i = 0; i < N; i++) {
+
+			if (!MD_IS_SET(flags, i) && (pos[i] != ra->last[i])) {
+
+				ra->dim = i;
+				ra->dir = (pos[i] > ra->last[i]) ? 1 : -1;
+			}
+		}
+	}
+
+	ra->first = false;
+	md_copy_dims(N, ra->last, pos);
+
+	release_slices(ra, budget, flags, pos);
+
+	// with a budget, faults read single pages, so the shown slice is read ahead first
+	if ((0 < budget) && (-1 == find_slice(ra, flags, pos)))
+		advise_slice(ra, flags, pos, HINT_WILLNEED);
+
+	if ((-1 == ra->dim) || MD_IS_SET(flags, ra->dim)) {
+
+		shown_slice(ra, budget, flags, pos);
+		return;
+	}
+
+	long npos[N];
+	md_copy_dims(N, npos, pos);
+
+	// with a budget, at most half of it is read ahead
+	long ahead = 0;
+
+	for (int k = 1; k <= READAHEAD_AHEAD + READAHEAD_BEHIND; k++) {
+
+		long s = (k <= READAHEAD_AHEAD) ? ra->dir * k : -ra->dir * (k - READAHEAD_AHEAD);
+
+		npos[ra->dim] = pos[ra->dim] + s;
+
+		if ((npos[ra->dim] < 0) || (ra->dims[ra->dim] <= npos[ra->dim]))
+			continue;
+
+		if (-1 != find_slice(ra, flags, npos))
+			continue;
+
+		if (0 < budget) {
+
+			long bytes = advise_slice(ra, flags, npos, HINT_NONE);
+
+			if (budget < 2 * (ahead + bytes))
+				break;
+
+			ahead += bytes;
+		}
+
+		add_slice(ra, budget, flags, npos, advise_slice(ra, flags, npos, HINT_WILLNEED));
+	}
+
+	// the next slice is probably shown soon
+	npos[ra->dim] = pos[ra->dim] + ra->dir;
+
+	if ((0 <= npos[ra->dim]) && (npos[ra->dim] < ra->dims[ra->dim]) && (-1 != find_slice(ra, flags, npos)))
+		advise_slice(ra, flags, npos, HINT_TOUCH);
+
+	shown_slice(ra, budget, flags, pos);
+}
+
+static int readahead_thread(void* _ra)
+{
+	struct readahead_s* ra = _ra;
+
+	long pos[ra->N];
+
+	mtx_lock(&ra->mx);
+
+	while (!ra->quit) {
+
+		if (!ra->request) {
+
+			cnd_wait(&ra->cnd, &ra->mx);
+			continue;
+		}
+
+		ra->request = false;
+
+		unsigned long flags = ra->flags;
+		long budget = ra->budget;
+		md_copy_dims(ra->N, pos, ra->pos);
+
+		mtx_unlock(&ra->mx);
+
+		mtx_lock(&ra->slices_mx);
+		readahead_update(ra, budget, flags, pos);
+		mtx_unlock(&ra->slices_mx);
+
+		mtx_lock(&ra->mx);
+	}
+
+	mtx_unlock(&ra->mx);
+
+	return 0;
+}
+
+
+static void free_readahead(struct readahead_s* ra)
+{
+	for (int i = 0; i < READAHEAD_SLICES; i++)
+		xfree(ra->slice_pos[i]);
+
+	xfree(ra->dims);
+	xfree(ra->strs);
+	xfree(ra->pos);
+	xfree(ra->last);
+	xfree(ra);
+}
+
+// hints for the memory of data on a helper thread, NULL if it cannot be started
+struct readahead_s* create_readahead(int N, const long dims[N], const complex float* data)
+{
+	struct readahead_s* ra = xmalloc(sizeof(struct readahead_s));
+
+	ra->N = N;
+	ra->dims = xmalloc(N * sizeof(long));
+	ra->strs = xmalloc(N * sizeof(long));
+	ra->pos = xmalloc(N * sizeof(long));
+	ra->last = xmalloc(N * sizeof(long));
+	ra->data = data;
+
+	md_copy_dims(N, ra->dims, dims);
+	md_calc_strides(N, ra->strs, dims, sizeof(complex float));
+
+	ra->size = md_calc_size(N, dims) * (long)sizeof(complex float);
+
+	ra->page = sysconf(_SC_PAGESIZE);
+
+	ra->quit = false;
+	ra->request = false;
+	ra->flags = 0;
+	ra->budget = 0;
+
+	ra->first = true;
+	ra->dim = -1;
+	ra->dir = 1;
+
+	ra->nslices = 0;
+	ra->resident = 0;
+	ra->keep = NULL;
+
+	for (int i = 0; i < READAHEAD_SLICES; i++)
+		ra->slice_pos[i] = xmalloc(N * sizeof(long));
+
+	mtx_init(&ra->mx, mtx_plain);
+	mtx_init(&ra->slices_mx, mtx_plain);
+	cnd_init(&ra->cnd);
+
+	if (thrd_success != thrd_create(&ra->thread, readahead_thread, ra)) {
+
+		cnd_destroy(&ra->cnd);
+		mtx_destroy(&ra->slices_mx);
+		mtx_destroy(&ra->mx);
+		free_readahead(ra);
+
+		return NULL;
+	}
+
+	call_once(&readahead_once, readahead_init);
+
+	mtx_lock(&readahead_mx);
+	ra->next = readahead_list;
+	readahead_list = ra;
+	mtx_unlock(&readahead_mx);
+
+	return ra;
+}
+
+void delete_readahead(struct readahead_s* ra)
+{
+	if (NULL == ra)
+		return;
+
+	mtx_lock(&readahead_mx);
+
+	struct readahead_s** p = &readahead_list;
+
+	while (ra != *p)
+		p = &(*p)->next;
+
+	*p = ra->next;
+
+	mtx_unlock(&readahead_mx);
+
+	mtx_lock(&ra->mx);
+	ra->quit = true;
+	cnd_broadcast(&ra->cnd);
+	mtx_unlock(&ra->mx);
+
+	thrd_join(ra->thread, NULL);
+
+	cnd_destroy(&ra->cnd);
+	mtx_destroy(&ra->slices_mx);
+	mtx_destroy(&ra->mx);
+	free_readahead(ra);
+}
+
+// pages of slices are released so that about bytes of the data stay resident, 0 for no limit
+void readahead_set_budget(struct readahead_s* ra, long bytes)
+{
+	if (NULL == ra)
+		return;
+
+	mtx_lock(&ra->mx);
+	ra->budget = bytes;
+	mtx_unlock(&ra->mx);
+
+	// faults read single pages and not whole windows of the file, what is needed is read ahead explicitly
+	uintptr_t a0 = (uintptr_t)ra->data;
+	a0 -= a0 % ra->page;
+
+	posix_madvise((void*)a0, (uintptr_t)ra->data + ra->size - a0, (0 < bytes) ? POSIX_MADV_RANDOM : POSIX_MADV_NORMAL);
+}
+
+// the slice at pos along the dims in flags is shown, neighbours along the dimension scrolled last are read ahead
+void readahead_position(struct readahead_s* ra, unsigned long flags, const long pos[])
+{
+	if (NULL == ra)
+		return;
+
+	mtx_lock(&ra->mx);
+
+	ra->request = true;
+	ra->flags = flags;
+	md_copy_dims(ra->N, ra->pos, pos);
+
+	cnd_signal(&ra->cnd);
+	mtx_unlock(&ra->mx);
+}
+
+
+/*
+ * The pages of data from start to end in bytes are paged out, except for
+ * pages of slices which are shown or read ahead for any view of the same
+ * data. A page which starts before start is kept.
+ */
+void readahead_release(const complex float* data, long start, long end)
+{
+	long page = sysconf(_SC_PAGESIZE);
+
+	uintptr_t a0 = (uintptr_t)data + start;
+	uintptr_t a1 = (uintptr_t)data + end;
+
+	a0 += (page - a0 % page) % page;
+
+	if (a1 <= a0)
+		return;
+
+	struct keep_s keep = { a0, (long)(a1 - a0 + page - 1) / page, NULL };
+
+	keep.keep = xmalloc(keep.n * sizeof(bool));
+
+	for (long i = 0; i < keep.n; i++)
+		keep.keep[i] = false;
+
+	call_once(&readahead_once, readahead_init);
+
+	mtx_lock(&readahead_mx);
+
+	for (struct readahead_s* ra = readahead_list; NULL != ra; ra = ra->next) {
+
+		if (data != ra->data)
+			continue;
+
+		mtx_lock(&ra->slices_mx);
+
+		ra->keep = &keep;
+
+		for (int i = 0; i < ra->nslices; i++)
+			advise_slice(ra, ra->slice_flags[i], ra->slice_pos[i], HINT_KEEP);
+
+		ra->keep = NULL;
+
+		mtx_unlock(&ra->slices_mx);
+	}
+
+	mtx_unlock(&readahead_mx);
+
+	for (long i = 0, j = 0; i < keep.n; i = j) {
+
+		for (j = i + 1; (j < keep.n) && (keep.keep[i] == keep.keep[j]); j++)
+			;
+
+		if (!keep.keep[i])
+			page_out((void*)(a0 + i * page), MIN(a1, a0 + j * page) - (a0 + i * page));
+	}
+
+	xfree(keep.keep);
+}
@@ -0,0 +1,18 @@
+#ifndef VIEW_READAHEAD_H
+#define VIEW_READAHEAD_H
+
+#include <complex.h>
+
+
+struct readahead_s;
+
+extern struct readahead_s* create_readahead(int N, const long dims[N], const complex float* data);
+extern void delete_readahead(struct readahead_s* ra);
+
+extern void readahead_set_budget(struct readahead_s* ra, long bytes);
+extern void readahead_position(struct readahead_s* ra, unsigned long flags, const long pos[]);
+
+extern void readahead_release(const complex float* data, long start, long end);
+
+#endif // VIEW_READAHEAD_H
+
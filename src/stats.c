@@ -0,0 +1,1384 @@
+/* Copyright 2026. TU Graz. Institute of Biomedical Imaging.
+ * All rights reserved. Use of this source code is governed by
+ * a BSD-style license which can be found in the LICENSE file.
+ */
+
+#define _GNU_SOURCE
+#include <math.h>
+#include <complex.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "num/multind.h"
+
+#include "misc/misc.h"
+
+#include "readahead.h"
+#include "stats.h"
+
+
+// statistics for all slices along the dims in flags
+struct stats_index_s {
+
+	unsigned long flags;
+
+	long* ldims;
+	long nslices;
+
+	bool* valid;
+	struct slice_stats_s* slice;
+
+	// computed on demand
+	struct histogram_s** hist;
+
+	struct stats_index_s* next;
+};
+
+struct stats_s {
+
+	int N;
+	long* dims;
+	long* strs;	// in elements
+	const complex float* data;
+
+	int refcount;
+	struct stats_s* next;
+
+	bool global_valid;
+	struct slice_stats_s global;
+
+	struct histogram_s* global_hist;
+
+	struct stats_index_s* index;
+
+	// whole-data scans in chunks of at most this many bytes, 0 for no limit
+	long budget;
+
+	struct stats_scan_s* scan;
+
+	// a stream has arrived up to this position along its dim, -1 otherwise
+	int stream;
+	long arrived;
+
+	// sidecar file
+	char* sidecar;
+	struct file_id_s {
+
+		uint64_t dev;
+		uint64_t ino;
+		int64_t size;
+		int64_t mtime;
+		int64_t mtime_ns;
+
+	} id;
+
+	unsigned int mode;
+	bool dirty;
+
+	bool writing;
+	thrd_t writer;
+};
+
+// shared between views of the same data, only used from the GUI thread
+static struct stats_s* stats_list = NULL;
+
+
+static struct slice_stats_s stats_merge(struct slice_stats_s a, struct slice_stats_s b)
+{
+	if (0 == a.count) {
+
+		b.nans += a.nans;
+		return b;
+	}
+
+	if (0 == b.count) {
+
+		a.nans += b.nans;
+		return a;
+	}
+
+	return (struct slice_stats_s){
+
+		.min = MIN(a.min, b.min),
+		.max = MAX(a.max, b.max),
+		.sum = a.sum + b.sum,
+		.count = a.count + b.count,
+		.nans = a.nans + b.nans,
+	};
+}
+
+// arrays are processed in rows along the first non-singleton dimension
+static int scan_rows(int N, const long dims[N], long* len, long* rows)
+{
+	int d0 = 0;
+
+	while ((d0 < N - 1) && (1 == dims[d0]))
+		d0++;
+
+	*len = dims[d0];
+	*rows = md_calc_size(N, dims) / dims[d0];
+
+	return d0;
+}
+
+static long row_offset(int N, int d0, const long dims[N], const long strs[N], long r)
+{
+	long off = 0;
+
+	for (int d = d0 + 1; d < N; d++) {
+
+		off += (r % dims[d]) * strs[d];
+		r /= dims[d];
+	}
+
+	return off;
+}
+
+// one pass over the array of size dims at data, parallel over rows
+static struct slice_stats_s stats_scan(int N, const long dims[N], const long strs[N], const complex float* data)
+{
+	long len;
+	long rows;
+	int d0 = scan_rows(N, dims, &len, &rows);
+	long str = strs[d0];
+
+	float mn = INFINITY;
+	float mx = 0.f;
+	double sum = 0.;
+	long count = 0;
+	long nans = 0;
+
+#pragma omp parallel for reduction(min:mn) reduction(max:mx) reduction(+:sum, count, nans)
+	for (long r = 0; r < rows; r++) {
+
+		const complex float* row = data + row_offset(N, d0, dims, strs, r);
+
+#pragma omp simd reduction(min:mn) reduction(max:mx) reduction(+:sum, count, nans)
+		for (long i = 0; i < len; i++) {
+
+			float re = crealf(row[i * str]);
+			float im = cimagf(row[i * str]);
+
+			bool ok = isfinite(re) && isfinite(im);
+			float m = sqrtf(re * re + im * im);
+
+			mn = fminf(mn, ok ? m : INFINITY);
+			mx = fmaxf(mx, ok ? m : 0.f);
+			sum += ok ? m : 0.f;
+			count += ok;
+			nans += !ok;
+		}
+	}
+
+	return (struct slice_stats_s){ mn, mx, sum, count, nans };
+}
+
+static inline int histogram_bin(float x)
+{
+	if (!(0.f < x))
+		return 0;
+
+	int e;
+	float f = frexpf(x, &e);
+
+	int o = e - 1 + STATS_OCTAVES;
+
+	if (o < 0)
+		return 0;
+
+	int b = o * STATS_BINS_OCTAVE + (int)((2.f * f - 1.f) * STATS_BINS_OCTAVE);
+
+	return MIN(b, STATS_BINS - 1);
+}
+
+// lower edge of a bin
+static double histogram_edge(const struct histogram_s* h, int b)
+{
+	if (0 == b)
+		return 0.;
+
+	int o = b / STATS_BINS_OCTAVE;
+	int sub = b % STATS_BINS_OCTAVE;
+
+	return h->max * ldexp(1. + (double)sub / STATS_BINS_OCTAVE, o - STATS_OCTAVES);
+}
+
+static struct histogram_s* histogram_scan(int N, const long dims[N], const long strs[N], const complex float* data, float max)
+{
+	struct histogram_s* h = xmalloc(sizeof(struct histogram_s));
+
+	h->max = max;
+
+	long* bins = h->bins;
+	memset(bins, 0, sizeof(h->bins));
+
+	long len;
+	long rows;
+	int d0 = scan_rows(N, dims, &len, &rows);
+	long str = strs[d0];
+
+	float sc = (0.f == max) ? 0.f : (1.f / max);
+
+#pragma omp parallel for reduction(+:bins[:STATS_BINS])
+	for (long r = 0; r < rows; r++) {
+
+		const complex float* row = data + row_offset(N, d0, dims, strs, r);
+
+		for (long i = 0; i < len; i++) {
+
+			float re = crealf(row[i * str]);
+			float im = cimagf(row[i * str]);
+
+			if (!(isfinite(re) && isfinite(im)))
+				continue;
+
+			bins[histogram_bin(sqrtf(re * re + im * im) * sc)]++;
+		}
+	}
+
+	return h;
+}
+
+// histograms which are added up have a power of two as range, so that they are rebinned exactly
+static float histogram_range(float max)
+{
+	if (!(0.f < max))
+		return max;
+
+	int e;
+	float f = frexpf(max, &e);
+
+	return (0.5f == f) ? max : ldexpf(1.f, e);
+}
+
+// a histogram for a larger maximum, the counts of a bin move with its center, or exactly by whole octaves
+static void histogram_rebin(struct histogram_s* h, float max)
+{
+	if (max <= h->max)
+		return;
+
+	// all samples are in the first bin
+	if (0.f == h->max) {
+
+		h->max = max;
+		return;
+	}
+
+	long bins[STATS_BINS] = { 0 };
+
+	int e;
+	bool octaves = (0.5f == frexpf(max / h->max, &e));
+
+	for (int i = 0; i < STATS_BINS; i++) {
+
+		if (0 == h->bins[i])
+			continue;
+
+		if (octaves) {
+
+			bins[MAX(0, i - (e - 1) * STATS_BINS_OCTAVE)] += h->bins[i];
+			continue;
+		}
+
+		double c = (0 == i) ? 0. : (0.5 * (histogram_edge(h, i) + histogram_edge(h, i + 1)));
+
+		bins[histogram_bin(c / max)] += h->bins[i];
+	}
+
+	memcpy(h->bins, bins, sizeof(bins));
+	h->max = max;
+}
+
+static void histogram_add(struct histogram_s* h, const struct histogram_s* a)
+{
+	for (int i = 0; i < STATS_BINS; i++)
+		h->bins[i] += a->bins[i];
+}
+
+#define STATS_READAHEAD (128ul << 10)
+
+// the next chunk is read ahead, pages of scanned chunks are not kept resident
+static void stats_advise(struct stats_s* st, long off, long len, bool release)
+{
+	long size = md_calc_size(st->N, st->dims);
+
+	len = MIN(len, size - off);
+
+	if (len <= 0)
+		return;
+
+	long page = sysconf(_SC_PAGESIZE);
+
+	uintptr_t a0 = (uintptr_t)(st->data + off);
+	uintptr_t a1 = (uintptr_t)(st->data + off + len);
+
+	/*
+	 * Pages shared with the chunk before or after are kept, the next one
+	 * has been read ahead already. Pages of slices which are shown or read
+	 * ahead stay resident for the render thread.
+	 */
+	if (release) {
+
+		if (off + len < size)
+			a1 -= a1 % page;
+
+		readahead_release(st->data, a0 - (uintptr_t)st->data, a1 - (uintptr_t)st->data);
+		return;
+	}
+
+	a0 -= a0 % page;
+
+	// the kernel reads ahead at most about its readahead window per hint
+	for (uintptr_t a = a0; a < a1; a += STATS_READAHEAD)
+		posix_madvise((void*)a, MIN(STATS_READAHEAD, a1 - a), POSIX_MADV_WILLNEED);
+}
+
+// rows of contiguous data which are scanned in parallel
+#define STATS_ROW 4096l
+
+// elements of the whole data scanned at once with a budget, with the next one read ahead at most half of it
+static long stats_chunk(struct stats_s* st)
+{
+	long chunk = st->budget / 4 / (long)sizeof(complex float);
+
+	return MAX(STATS_ROW, chunk - chunk % STATS_ROW);
+}
+
+// scan of all data on a helper thread
+struct stats_scan_s {
+
+	mtx_t mx;
+	thrd_t thread;
+
+	bool quit;
+	bool done;
+	double progress;
+
+	bool ok;
+	struct slice_stats_s global;
+	struct histogram_s* hist;
+};
+
+// a chunk of contiguous data, in rows which are scanned in parallel
+static void chunk_scan(const complex float* data, long n, struct slice_stats_s* s, struct histogram_s* h)
+{
+	long dims[2] = { STATS_ROW, n / STATS_ROW };
+	long strs[2] = { 1, STATS_ROW };
+	long rest = n % STATS_ROW;
+
+	if (NULL == h) {
+
+		if (0 < dims[1])
+			*s = stats_merge(*s, stats_scan(2, dims, strs, data));
+
+		if (0 < rest)
+			*s = stats_merge(*s, stats_scan(1, &rest, strs, data + n - rest));
+
+		return;
+	}
+
+	struct histogram_s* p[2] = {
+
+		(0 < dims[1]) ? histogram_scan(2, dims, strs, data, h->max) : NULL,
+		(0 < rest) ? histogram_scan(1, &rest, strs, data + n - rest, h->max) : NULL,
+	};
+
+	for (int j = 0; j < 2; j++) {
+
+		if (NULL == p[j])
+			continue;
+
+		histogram_add(h, p[j]);
+		xfree(p[j]);
+	}
+}
+
+/*
+ * Statistics and histogram of all data in one pass over chunks, which
+ * are read ahead and paged out afterwards. The histogram is rebinned
+ * when the maximum grows. Returns false if the scan was stopped.
+ */
+static bool stats_scan_all(struct stats_s* st, struct slice_stats_s* s, struct histogram_s* h, struct stats_scan_s* sc)
+{
+	long size = md_calc_size(st->N, st->dims);
+	long chunk = stats_chunk(st);
+
+	*s = (struct slice_stats_s){ 0 };
+
+	h->max = 0.f;
+	memset(h->bins, 0, sizeof(h->bins));
+
+	stats_advise(st, 0, chunk, false);
+
+	for (long o = 0; o < size; o += chunk) {
+
+		if (NULL != sc) {
+
+			mtx_lock(&sc->mx);
+
+			bool quit = sc->quit;
+			sc->progress = (double)o / size;
+
+			mtx_unlock(&sc->mx);
+
+			if (quit)
+				return false;
+		}
+
+		long n = MIN(chunk, size - o);
+
+		stats_advise(st, o + chunk, chunk, false);
+
+		// the chunk is resident now, only the i/o is done once
+		chunk_scan(st->data + o, n, s, NULL);
+		histogram_rebin(h, histogram_range(s->max));
+		chunk_scan(st->data + o, n, NULL, h);
+
+		stats_advise(st, o, n, true);
+	}
+
+	return true;
+}
+
+static void stats_set_global(struct stats_s* st, struct slice_stats_s s, struct histogram_s* h)
+{
+	st->global = s;
+	st->global_valid = true;
+
+	xfree(st->global_hist);
+	st->global_hist = h;
+
+	st->dirty = true;
+}
+
+static void stats_global_chunked(struct stats_s* st)
+{
+	struct slice_stats_s s;
+	struct histogram_s* h = xmalloc(sizeof(struct histogram_s));
+
+	stats_scan_all(st, &s, h, NULL);
+	stats_set_global(st, s, h);
+}
+
+static int stats_scan_thread(void* _st)
+{
+	struct stats_s* st = _st;
+	struct stats_scan_s* sc = st->scan;
+
+	struct slice_stats_s s;
+	struct histogram_s* h = xmalloc(sizeof(struct histogram_s));
+
+	bool ok = stats_scan_all(st, &s, h, sc);
+
+	mtx_lock(&sc->mx);
+
+	sc->ok = ok;
+	sc->global = s;
+	sc->hist = h;
+	sc->done = true;
+
+	mtx_unlock(&sc->mx);
+
+	return 0;
+}
+
+static void stats_scan_stop(struct stats_s* st)
+{
+	struct stats_scan_s* sc = st->scan;
+
+	mtx_lock(&sc->mx);
+	sc->quit = true;
+	mtx_unlock(&sc->mx);
+
+	thrd_join(sc->thread, NULL);
+
+	xfree(sc->hist);
+	mtx_destroy(&sc->mx);
+	xfree(sc);
+
+	st->scan = NULL;
+}
+
+static struct stats_index_s* stats_index(struct stats_s* st, unsigned long flags)
+{
+	for (struct stats_index_s* ind = st->index; NULL != ind; ind = ind->next)
+		if (flags == ind->flags)
+			return ind;
+
+	int N = st->N;
+
+	struct stats_index_s* ind = xmalloc(sizeof(struct stats_index_s));
+
+	ind->flags = flags;
+	ind->ldims = xmalloc(N * sizeof(long));
+
+	md_select_dims(N, ~flags, ind->ldims, st->dims);
+
+	ind->nslices = md_calc_size(N, ind->ldims);
+	ind->valid = xmalloc(ind->nslices * sizeof(bool));
+	ind->slice = xmalloc(ind->nslices * sizeof(struct slice_stats_s));
+	ind->hist = xmalloc(ind->nslices * sizeof(struct histogram_s*));
+
+	memset(ind->valid, 0, ind->nslices * sizeof(bool));
+	memset(ind->hist, 0, ind->nslices * sizeof(struct histogram_s*));
+
+	ind->next = st->index;
+	st->index = ind;
+
+	return ind;
+}
+
+static const complex float* slice_data(struct stats_s* st, struct stats_index_s* ind, long i)
+{
+	long off = 0;
+
+	for (int d = 0; d < st->N; d++) {
+
+		off += (i % ind->ldims[d]) * st->strs[d];
+		i /= ind->ldims[d];
+	}
+
+	return st->data + off;
+}
+
+static void stats_fill(struct stats_s* st, struct stats_index_s* ind, long i)
+{
+	int N = st->N;
+
+	long sdims[N];
+	md_select_dims(N, ind->flags, sdims, st->dims);
+
+	ind->slice[i] = stats_scan(N, sdims, st->strs, slice_data(st, ind, i));
+	ind->valid[i] = true;
+}
+
+static long slice_index(struct stats_s* st, struct stats_index_s* ind, const long pos[])
+{
+	long i = 0;
+
+	for (int d = st->N - 1; d >= 0; d--)
+		i = i * ind->ldims[d] + (MD_IS_SET(ind->flags, d) ? 0 : pos[d]);
+
+	return i;
+}
+
+static void histograms_free(struct stats_s* st)
+{
+	xfree(st->global_hist);
+	st->global_hist = NULL;
+
+	for (struct stats_index_s* ind = st->index; NULL != ind; ind = ind->next) {
+
+		for (long i = 0; i < ind->nslices; i++) {
+
+			xfree(ind->hist[i]);
+			ind->hist[i] = NULL;
+		}
+	}
+}
+
+// global statistics and histogram are built up from parts of the data
+static void global_clear(struct stats_s* st)
+{
+	st->global = (struct slice_stats_s){ 0 };
+
+	xfree(st->global_hist);
+	st->global_hist = xmalloc(sizeof(struct histogram_s));
+
+	st->global_hist->max = 0.f;
+	memset(st->global_hist->bins, 0, sizeof(st->global_hist->bins));
+}
+
+// h is the histogram of the part with statistics s, it is rebinned
+static void global_add(struct stats_s* st, struct slice_stats_s s, struct histogram_s* h)
+{
+	st->global = stats_merge(st->global, s);
+
+	histogram_rebin(st->global_hist, histogram_range(st->global.max));
+	histogram_rebin(h, st->global_hist->max);
+	histogram_add(st->global_hist, h);
+}
+
+// frames [start, end) of the stream are added one by one
+static void stream_add(struct stats_s* st, long start, long end)
+{
+	int N = st->N;
+
+	long fdims[N];
+	md_copy_dims(N, fdims, st->dims);
+	fdims[st->stream] = 1;
+
+	for (long f = start; f < end; f++) {
+
+		const complex float* data = st->data + f * st->strs[st->stream];
+
+		struct slice_stats_s s = stats_scan(N, fdims, st->strs, data);
+		struct histogram_s* h = histogram_scan(N, fdims, st->strs, data, histogram_range(s.max));
+
+		global_add(st, s, h);
+		xfree(h);
+	}
+}
+
+static struct slice_stats_s stats_final(struct slice_stats_s s)
+{
+	if (0 == s.count)
+		s.min = 0.f;
+
+	return s;
+}
+
+
+/*
+ * Statistics are computed once and shared between all views
+ * of the same data.
+ */
+struct stats_s* create_stats(int N, const long dims[N], const complex float* data)
+{
+	for (struct stats_s* st = stats_list; NULL != st; st = st->next) {
+
+		if (   (data == st->data) && (N == st->N)
+		    && (0 == memcmp(dims, st->dims, N * sizeof(long)))) {
+
+			st->refcount++;
+			return st;
+		}
+	}
+
+	struct stats_s* st = xmalloc(sizeof(struct stats_s));
+
+	st->N = N;
+	st->dims = xmalloc(N * sizeof(long));
+	st->strs = xmalloc(N * sizeof(long));
+	st->data = data;
+
+	md_copy_dims(N, st->dims, dims);
+	md_calc_strides(N, st->strs, dims, 1);
+
+	st->refcount = 1;
+	st->global_valid = false;
+	st->global_hist = NULL;
+	st->index = NULL;
+	st->budget = 0;
+	st->scan = NULL;
+	st->stream = -1;
+	st->arrived = 0;
+
+	st->sidecar = NULL;
+	st->dirty = false;
+	st->writing = false;
+
+	st->next = stats_list;
+	stats_list = st;
+
+	return st;
+}
+
+void delete_stats(struct stats_s* st)
+{
+	if (0 < --st->refcount)
+		return;
+
+	struct stats_s** p = &stats_list;
+
+	while (st != *p)
+		p = &(*p)->next;
+
+	*p = st->next;
+
+	if (NULL != st->scan)
+		stats_scan_stop(st);
+
+	if (st->dirty)
+		stats_save(st, false);
+
+	if (st->writing)
+		thrd_join(st->writer, NULL);
+
+	xfree(st->sidecar);
+
+	histograms_free(st);
+
+	while (NULL != st->index) {
+
+		struct stats_index_s* ind = st->index;
+		st->index = ind->next;
+
+		xfree(ind->ldims);
+		xfree(ind->valid);
+		xfree(ind->slice);
+		xfree(ind->hist);
+		xfree(ind);
+	}
+
+	xfree(st->dims);
+	xfree(st->strs);
+	xfree(st);
+}
+
+// the data has changed
+void stats_invalidate(struct stats_s* st)
+{
+	st->global_valid = false;
+	st->dirty = true;
+
+	histograms_free(st);
+
+	for (struct stats_index_s* ind = st->index; NULL != ind; ind = ind->next)
+		memset(ind->valid, 0, ind->nslices * sizeof(bool));
+}
+
+/*
+ * The data is a stream along dim, which has arrived up to the position
+ * before arrived. The statistics only include frames which have arrived.
+ */
+void stats_set_stream(struct stats_s* st, int dim, long arrived)
+{
+	// by another view of the same stream
+	if (0 <= st->stream)
+		return;
+
+	st->stream = dim;
+	st->arrived = MIN(arrived, st->dims[dim]);
+}
+
+/*
+ * New data of a stream has arrived up to the position before end along
+ * dim, at least from start on. Frames which were added before, also for
+ * another view of the same stream, are not added again. Only the
+ * statistics which include new positions are dropped, and the new frames
+ * are scanned in place. Returns the statistics of all frames which have
+ * arrived.
+ */
+struct slice_stats_s stats_append(struct stats_s* st, int dim, long start, long end)
+{
+	end = MIN(end, st->dims[dim]);
+
+	stats_set_stream(st, dim, start);
+
+	start = st->arrived;
+
+	if (start >= end)
+		return stats_global(st, MD_BIT(dim));
+
+	st->arrived = end;
+	st->dirty = true;
+
+	for (struct stats_index_s* ind = st->index; NULL != ind; ind = ind->next) {
+
+		// positions along dim of consecutive slices
+		long lstr = 1;
+
+		for (int d = 0; d < dim; d++)
+			lstr *= ind->ldims[d];
+
+		for (long i = 0; i < ind->nslices; i++) {
+
+			long p = (i / lstr) % ind->ldims[dim];
+
+			if (MD_IS_SET(ind->flags, dim) || ((start <= p) && (p < end))) {
+
+				ind->valid[i] = false;
+
+				xfree(ind->hist[i]);
+				ind->hist[i] = NULL;
+			}
+		}
+	}
+
+	// running aggregates, over the new frames only
+	if (st->global_valid && (NULL != st->global_hist))
+		stream_add(st, start, end);
+
+	return stats_global(st, MD_BIT(dim));
+}
+
+// statistics of the slice along flags which contains pos
+struct slice_stats_s stats_slice(struct stats_s* st, unsigned long flags, const long pos[])
+{
+	struct stats_index_s* ind = stats_index(st, flags);
+
+	long i = slice_index(st, ind, pos);
+
+	if (!ind->valid[i]) {
+
+		stats_fill(st, ind, i);
+		st->dirty = true;
+	}
+
+	return stats_final(ind->slice[i]);
+}
+
+// whole-data scans keep at most about bytes of the data resident, 0 for no limit
+void stats_set_budget(struct stats_s* st, long bytes)
+{
+	st->budget = bytes;
+}
+
+// statistics of the slices along flags scanned so far, frac is the part of the data they cover
+struct slice_stats_s stats_known(struct stats_s* st, unsigned long flags, double* frac)
+{
+	*frac = 1.;
+
+	if (st->global_valid && (NULL != st->global_hist))
+		return stats_final(st->global);
+
+	struct stats_index_s* ind = stats_index(st, flags);
+
+	struct slice_stats_s s = { 0 };
+	long n = 0;
+
+	for (long i = 0; i < ind->nslices; i++) {
+
+		if (!ind->valid[i])
+			continue;
+
+		s = stats_merge(s, ind->slice[i]);
+		n++;
+	}
+
+	*frac = (double)n / ind->nslices;
+
+	return stats_final(s);
+}
+
+/*
+ * Global statistics and histogram, made in the same pass over the data.
+ * The histogram of each part is made while the part is still cached.
+ * Fills the index for flags on the way unless there is a budget.
+ */
+struct slice_stats_s stats_global(struct stats_s* st, unsigned long flags)
+{
+	if (st->global_valid && (NULL != st->global_hist))
+		return stats_final(st->global);
+
+	// frames which have not arrived are not included
+	if (0 <= st->stream) {
+
+		global_clear(st);
+		stream_add(st, 0, st->arrived);
+
+		st->global_valid = true;
+
+		return stats_final(st->global);
+	}
+
+	if (0 < st->budget) {
+
+		stats_global_chunked(st);
+
+		return stats_final(st->global);
+	}
+
+	global_clear(st);
+
+	int N = st->N;
+
+	struct stats_index_s* ind = stats_index(st, flags);
+
+	long sdims[N];
+	md_select_dims(N, flags, sdims, st->dims);
+
+	// few large slices are scanned in parallel one after another
+#pragma omp parallel for schedule(dynamic) if (64 <= ind->nslices)
+	for (long i = 0; i < ind->nslices; i++) {
+
+		if (!ind->valid[i])
+			stats_fill(st, ind, i);
+
+		struct histogram_s* h;
+
+		if (NULL != ind->hist[i]) {
+
+			h = xmalloc(sizeof(struct histogram_s));
+			*h = *ind->hist[i];
+
+		} else {
+
+			h = histogram_scan(N, sdims, st->strs, slice_data(st, ind, i), histogram_range(ind->slice[i].max));
+		}
+
+#pragma omp critical
+		global_add(st, ind->slice[i], h);
+
+		xfree(h);
+	}
+
+	st->global_valid = true;
+	st->dirty = true;
+
+	return stats_final(st->global);
+}
+
+/*
+ * Start a scan of all data for the global statistics and histogram on a
+ * helper thread. Returns false if there is nothing to scan.
+ */
+bool stats_scan_background(struct stats_s* st)
+{
+	if (NULL != st->scan)
+		return true;
+
+	if (st->global_valid && (NULL != st->global_hist))
+		return false;
+
+	struct stats_scan_s* sc = xmalloc(sizeof(struct stats_scan_s));
+
+	sc->quit = false;
+	sc->done = false;
+	sc->progress = 0.;
+	sc->ok = false;
+	sc->hist = NULL;
+
+	mtx_init(&sc->mx, mtx_plain);
+
+	st->scan = sc;
+
+	if (thrd_success != thrd_create(&sc->thread, stats_scan_thread, st)) {
+
+		mtx_destroy(&sc->mx);
+		xfree(sc);
+		st->scan = NULL;
+
+		stats_global_chunked(st);
+
+		return false;
+	}
+
+	return true;
+}
+
+// true while the scan runs, the results are taken over when it has finished
+bool stats_scan_poll(struct stats_s* st, double* progress)
+{
+	struct stats_scan_s* sc = st->scan;
+
+	if (NULL == sc)
+		return false;
+
+	mtx_lock(&sc->mx);
+
+	bool done = sc->done;
+	*progress = sc->progress;
+
+	mtx_unlock(&sc->mx);
+
+	if (!done)
+		return true;
+
+	if (sc->ok) {
+
+		stats_set_global(st, sc->global, sc->hist);
+		sc->hist = NULL;
+	}
+
+	stats_scan_stop(st);
+
+	return false;
+}
+
+double stats_mean(struct slice_stats_s s)
+{
+	return (0 == s.count) ? 0. : (s.sum / s.count);
+}
+
+
+// histogram of the slice along flags which contains pos, the range is the maximum of the slice
+const struct histogram_s* stats_histogram_slice(struct stats_s* st, unsigned long flags, const long pos[])
+{
+	struct slice_stats_s s = stats_slice(st, flags, pos);
+
+	struct stats_index_s* ind = stats_index(st, flags);
+
+	long i = slice_index(st, ind, pos);
+
+	if (NULL == ind->hist[i]) {
+
+		int N = st->N;
+
+		long sdims[N];
+		md_select_dims(N, flags, sdims, st->dims);
+
+		ind->hist[i] = histogram_scan(N, sdims, st->strs, slice_data(st, ind, i), s.max);
+
+		st->dirty = true;
+	}
+
+	return ind->hist[i];
+}
+
+// histogram of all data, the range is the global maximum, made with the global statistics
+const struct histogram_s* stats_histogram_global(struct stats_s* st, unsigned long flags)
+{
+	stats_global(st, flags);
+
+	return st->global_hist;
+}
+
+// value below which a fraction p of the finite samples lie, linear within a bin
+double stats_percentile(const struct histogram_s* h, double p)
+{
+	long total = 0;
+
+	for (int i = 0; i < STATS_BINS; i++)
+		total += h->bins[i];
+
+	if (0 == total)
+		return 0.;
+
+	double target = p * total;
+	long cum = 0;
+
+	for (int i = 0; i < STATS_BINS; i++) {
+
+		if (cum + h->bins[i] >= target) {
+
+			double f = (0 == h->bins[i]) ? 0. : ((target - cum) / h->bins[i]);
+
+			double a = histogram_edge(h, i);
+
+			return a + f * (histogram_edge(h, i + 1) - a);
+		}
+
+		cum += h->bins[i];
+	}
+
+	return h->max;
+}
+
+// fractional bin index of a value
+double stats_histogram_position(const struct histogram_s* h, double value)
+{
+	if (0. == h->max)
+		return 0.;
+
+	if (value >= h->max)
+		return STATS_BINS;
+
+	int b = histogram_bin(value / h->max);
+
+	double a = histogram_edge(h, b);
+
+	return b + MAX(0., (value - a) / (histogram_edge(h, b + 1) - a));
+}
+
+
+
+/*
+ * Sidecar file <name>.stats next to <name>.cfl with all statistics
+ * computed so far. It is only used if size, modification time, and
+ * inode of the data file are unchanged.
+ */
+
+static const char stats_magic[8] = "VIEWST01";
+
+struct stats_header_s {
+
+	char magic[8];
+	int32_t sizes[3];
+	int32_t N;
+	struct file_id_s id;
+};
+
+struct sbuf_s {
+
+	char* data;
+	size_t len;
+	size_t size;
+};
+
+static void put(struct sbuf_s* b, const void* x, size_t len)
+{
+	if (b->len + len > b->size) {
+
+		b->size = MAX(2 * b->size, b->len + len);
+		b->data = realloc(b->data, b->size);
+
+		if (NULL == b->data)
+			abort();
+	}
+
+	memcpy(b->data + b->len, x, len);
+	b->len += len;
+}
+
+static bool get(void* x, size_t len, FILE* fp)
+{
+	return 1 == fread(x, len, 1, fp);
+}
+
+static bool file_id(struct file_id_s* id, unsigned int* mode, const char* name)
+{
+	struct stat sb;
+
+	if (0 != stat(name, &sb))
+		return false;
+
+	*mode = sb.st_mode & 0666;
+
+	*id = (struct file_id_s){
+
+		.dev = sb.st_dev,
+		.ino = sb.st_ino,
+		.size = sb.st_size,
+		.mtime = sb.st_mtime,
+#ifdef __APPLE__
+		.mtime_ns = sb.st_mtimespec.tv_nsec,
+#else
+		.mtime_ns = sb.st_mtim.tv_nsec,
+#endif
+	};
+
+	return true;
+}
+
+static struct stats_header_s stats_header(struct stats_s* st)
+{
+	struct stats_header_s h;
+
+	memset(&h, 0, sizeof(h));
+	memcpy(h.magic, stats_magic, sizeof(h.magic));
+
+	h.sizes[0] = sizeof(long);
+	h.sizes[1] = sizeof(struct slice_stats_s);
+	h.sizes[2] = sizeof(struct histogram_s);
+	h.N = st->N;
+	h.id = st->id;
+
+	return h;
+}
+
+static void stats_serialize(struct sbuf_s* b, struct stats_s* st)
+{
+	struct stats_header_s h = stats_header(st);
+
+	put(b, &h, sizeof(h));
+	put(b, st->dims, st->N * sizeof(long));
+
+	put(b, &st->global_valid, sizeof(bool));
+	put(b, &st->global, sizeof(struct slice_stats_s));
+
+	bool hist = (NULL != st->global_hist);
+
+	put(b, &hist, sizeof(bool));
+
+	if (hist)
+		put(b, st->global_hist, sizeof(struct histogram_s));
+
+	int nind = 0;
+
+	for (struct stats_index_s* ind = st->index; NULL != ind; ind = ind->next)
+		nind++;
+
+	put(b, &nind, sizeof(int));
+
+	for (struct stats_index_s* ind = st->index; NULL != ind; ind = ind->next) {
+
+		put(b, &ind->flags, sizeof(unsigned long));
+		put(b, ind->valid, ind->nslices * sizeof(bool));
+		put(b, ind->slice, ind->nslices * sizeof(struct slice_stats_s));
+
+		long nhist = 0;
+
+		for (long i = 0; i < ind->nslices; i++)
+			if (NULL != ind->hist[i])
+				nhist++;
+
+		put(b, &nhist, sizeof(long));
+
+		for (long i = 0; i < ind->nslices; i++) {
+
+			if (NULL == ind->hist[i])
+				continue;
+
+			put(b, &i, sizeof(long));
+			put(b, ind->hist[i], sizeof(struct histogram_s));
+		}
+	}
+}
+
+static bool stats_deserialize(struct stats_s* st, FILE* fp)
+{
+	struct stats_header_s h;
+	struct stats_header_s h2 = stats_header(st);
+
+	if (!get(&h, sizeof(h), fp) || (0 != memcmp(&h, &h2, sizeof(h))))
+		return false;
+
+	long dims[st->N];
+
+	if (!get(dims, sizeof(dims), fp) || (0 != memcmp(dims, st->dims, sizeof(dims))))
+		return false;
+
+	bool hist;
+
+	if (   !get(&st->global_valid, sizeof(bool), fp)
+	    || !get(&st->global, sizeof(struct slice_stats_s), fp)
+	    || !get(&hist, sizeof(bool), fp))
+		return false;
+
+	if (hist) {
+
+		st->global_hist = xmalloc(sizeof(struct histogram_s));
+
+		if (!get(st->global_hist, sizeof(struct histogram_s), fp))
+			return false;
+	}
+
+	int nind;
+
+	if (!get(&nind, sizeof(int), fp))
+		return false;
+
+	for (int j = 0; j < nind; j++) {
+
+		unsigned long flags;
+
+		if (!get(&flags, sizeof(unsigned long), fp))
+			return false;
+
+		struct stats_index_s* ind = stats_index(st, flags);
+
+		long nhist;
+
+		if (   !get(ind->valid, ind->nslices * sizeof(bool), fp)
+		    || !get(ind->slice, ind->nslices * sizeof(struct slice_stats_s), fp)
+		    || !get(&nhist, sizeof(long), fp))
+			return false;
+
+		for (long k = 0; k < nhist; k++) {
+
+			long i;
+
+			if (!get(&i, sizeof(long), fp) || (i < 0) || (i >= ind->nslices) || (NULL != ind->hist[i]))
+				return false;
+
+			ind->hist[i] = xmalloc(sizeof(struct histogram_s));
+
+			if (!get(ind->hist[i], sizeof(struct histogram_s), fp))
+				return false;
+		}
+	}
+
+	return true;
+}
+
+/*
+ * Use a sidecar for the data loaded from <name>.cfl
+ * and load it if it is up to date.
+ */
+void stats_attach_file(struct stats_s* st, const char* name)
+{
+	if (NULL != st->sidecar)
+		return;
+
+	char* cfl = xmalloc(strlen(name) + 5);
+	sprintf(cfl, "%s.cfl", name);
+
+	bool ok = file_id(&st->id, &st->mode, cfl);
+
+	xfree(cfl);
+
+	if (!ok)
+		return;
+
+	st->sidecar = xmalloc(strlen(name) + 7);
+	sprintf(st->sidecar, "%s.stats", name);
+
+	FILE* fp = fopen(st->sidecar, "r");
+
+	if (NULL == fp)
+		return;
+
+	// start from scratch
+	if (!stats_deserialize(st, fp))
+		stats_invalidate(st);
+
+	st->dirty = false;
+
+	fclose(fp);
+}
+
+struct stats_write_s {
+
+	char* name;
+	unsigned int mode;
+	struct sbuf_s buf;
+};
+
+static int stats_write(void* _w)
+{
+	struct stats_write_s* w = _w;
+
+	// write to a temporary file and rename, so that readers never see a partial file
+	char* tmp = xmalloc(strlen(w->name) + 8);
+	sprintf(tmp, "%s.XXXXXX", w->name);
+
+	int fd = mkstemp(tmp);
+
+	if (0 <= fd) {
+
+		// same permissions as the data
+		fchmod(fd, w->mode);
+
+		FILE* fp = fdopen(fd, "w");
+
+		bool ok = (NULL != fp) && (1 == fwrite(w->buf.data, w->buf.len, 1, fp));
+
+		if (NULL != fp)
+			ok = (0 == fclose(fp)) && ok;
+		else
+			close(fd);
+
+		if (!ok || (0 != rename(tmp, w->name)))
+			unlink(tmp);
+	}
+
+	xfree(tmp);
+	xfree(w->name);
+	free(w->buf.data);
+	xfree(w);
+
+	return 0;
+}
+
+// write the sidecar, optionally on a background thread
+void stats_save(struct stats_s* st, bool background)
+{
+	if ((NULL == st->sidecar) || !st->dirty)
+		return;
+
+	if (st->writing) {
+
+		thrd_join(st->writer, NULL);
+		st->writing = false;
+	}
+
+	struct stats_write_s* w = xmalloc(sizeof(struct stats_write_s));
+
+	w->name = strdup(st->sidecar);
+	w->mode = st->mode;
+	w->buf = (struct sbuf_s){ NULL, 0, 0 };
+
+	if (NULL == w->name)
+		abort();
+
+	stats_serialize(&w->buf, st);
+
+	st->dirty = false;
+
+	if (background && (thrd_success == thrd_create(&st->writer, stats_write, w))) {
+
+		st->writing = true;
+		return;
+	}
+
+	stats_write(w);
+}
@@ -0,0 +1,62 @@
+#ifndef VIEW_STATS_H
+#define VIEW_STATS_H
+
+#include <complex.h>
+#include <stdbool.h>
+
+
+// statistics of the magnitude, non-finite samples are only counted
+struct slice_stats_s {
+
+	float min;
+	float max;
+	double sum;
+	long count;	// finite samples
+	long nans;	// non-finite samples
+};
+
+// logarithmic bins, so that a few hot voxels do not squeeze everything else into one bin
+#ifndef STATS_OCTAVES
+#define STATS_OCTAVES 24
+#endif
+#define STATS_BINS_OCTAVE 128
+#define STATS_BINS (STATS_OCTAVES * STATS_BINS_OCTAVE)
+
+// histogram of the magnitude of finite samples, the bins cover [0, max], the first one everything below max / 2^STATS_OCTAVES
+struct histogram_s {
+
+	float max;
+	long bins[STATS_BINS];
+};
+
+struct stats_s;
+
+extern struct stats_s* create_stats(int N, const long dims[N], const complex float* data);
+extern void delete_stats(struct stats_s* st);
+
+extern void stats_set_budget(struct stats_s* st, long bytes);
+
+extern void stats_invalidate(struct stats_s* st);
+extern void stats_set_stream(struct stats_s* st, int dim, long arrived);
+extern struct slice_stats_s stats_append(struct stats_s* st, int dim, long start, long end);
+
+extern void stats_attach_file(struct stats_s* st, const char* name);
+extern void stats_save(struct stats_s* st, bool background);
+
+extern struct slice_stats_s stats_slice(struct stats_s* st, unsigned long flags, const long pos[]);
+extern struct slice_stats_s stats_global(struct stats_s* st, unsigned long flags);
+extern struct slice_stats_s stats_known(struct stats_s* st, unsigned long flags, double* frac);
+
+extern bool stats_scan_background(struct stats_s* st);
+extern bool stats_scan_poll(struct stats_s* st, double* progress);
+
+extern double stats_mean(struct slice_stats_s s);
+
+extern const struct histogram_s* stats_histogram_slice(struct stats_s* st, unsigned long flags, const long pos[]);
+extern const struct histogram_s* stats_histogram_global(struct stats_s* st, unsigned long flags);
+
+extern double stats_percentile(const struct histogram_s* h, double p);
+extern double stats_histogram_position(const struct histogram_s* h, double value);
+
+#endif // VIEW_STATS_H
+
@@ -10,7 +10,9 @@
 #include <math.h>
 #include <stdatomic.h>
 #include <threads.h>
+#include <time.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "gtk_ui.h"
 
@@ -28,6 +30,9 @@
 #endif
 
 #include "draw.h"
+#include "stats.h"
+#include "readahead.h"
+#include "layout.h"
 
 #include "view.h"
 
@@ -36,6 +41,166 @@
 #define DIMS 16
 #endif
 
+// box-filtered copy of the displayed plane for zoom factors below one
+struct reduced_s {
+
+	complex float* data;
+	long dims[DIMS];
+
+	// key
+	long pos[DIMS];
+	int xdim;
+	int ydim;
+	int fx;
+	int fy;
+	bool mag;
+};
+
+// frame handed over from the render thread to the GUI
+struct frame_s {
+
+	unsigned char* rgb;
+	long size;
+
+	// region of the zoomed image
+	int x;
+	int y;
+	int w;
+	int h;
+	int str;
+	int width;
+	int height;
+
+	bool cross_hair;
+	long cross_pos[2];
+};
+
+// everything a rendered frame depends on apart from its region
+struct frame_key_s {
+
+	long pos[DIMS];
+
+	int xdim;
+	int ydim;
+	double xzoom;
+	double yzoom;
+
+	enum flip_t flip;
+	enum mode_t mode;
+	enum color_t ctab;
+	enum interp_t interpolation;
+
+	double winlow;
+	double winhigh;
+	double phrot;
+	float scale;
+
+	bool cross_hair;
+	bool plot;
+
+	// the interpolated image does not depend on the windowing, it is kept for its region only
+	enum { LAYER_RGB, LAYER_BUF } layer;
+	int region[4];
+	bool native;
+};
+
+// frames shown recently, the least recently used is dropped first, owned by the render thread
+#ifndef HISTORY_FRAMES
+#define HISTORY_FRAMES 1024
+#endif
+
+struct history_s {
+
+	long budget;
+	long bytes;
+
+	long clock;
+	int count;
+
+	struct history_entry_s {
+
+		unsigned long hash;
+		long used;
+
+		struct frame_key_s key;
+
+		// a frame for LAYER_RGB, an interpolated image for LAYER_BUF
+		struct frame_s frame;
+
+		struct history_buf_s {
+
+			complex float* data;
+			long size;	// in bytes
+
+		} buf;
+
+	} entry[HISTORY_FRAMES];
+};
+
+// cine playback, workers render the frames ahead into a queue
+#ifndef CINE_QUEUE
+#define CINE_QUEUE 8
+#endif
+
+#ifndef CINE_WORKERS
+#define CINE_WORKERS 2
+#endif
+
+struct cine_s {
+
+	int dim;
+	long len;
+	double fps;
+
+	// frame n of the playback is at position (start + n) % len
+	long start;
+	double t0;
+
+	// frames which were not ready in time count as dropped
+	long shown;
+	long dropped;
+
+	// achieved frame rate, measured over about a second
+	double rate_t0;
+	long rate_frames;
+	double rate;
+
+	// protected by the lock of the view
+	struct cine_slot_s {
+
+		long seq;	// -1 if free
+		bool done;
+		struct frame_key_s key;
+		struct frame_s frame;
+
+	} queue[CINE_QUEUE];
+
+	bool quit;
+	cnd_t cnd;
+
+	struct view_s* v;
+	thrd_t workers[CINE_WORKERS];
+};
+
+// settings taken over by the render thread in addition to view_settings_s
+struct render_job_s {
+
+	bool invalid;
+	bool rgb_invalid;
+	bool refine;
+	bool clip;
+
+	int visx;
+	int visy;
+	int visw;
+	int vish;
+
+	float scale;
+
+	long history;
+	bool history_buf;
+};
+
 struct view_control_s {
 
 	// change-management
@@ -47,23 +212,111 @@ struct view_control_s {
 	long strs[DIMS];
 	const complex float* data;
 
+	// data as read by the renderer, from a copy with the shown dims innermost when it is ready
+	long rstrs[DIMS];
+	const complex float* rdata;
+
+	bool layout_copy;
+	struct layout_s* layout;
+
+	struct stats_s* stats;
+
+	// part of the data the statistics for the windowing cover
+	double stats_known;
+
+	// out-of-core, about this many bytes of the data stay resident, 0 for no limit
+	long resident;
+	bool scanning;
+
+	// hints for the pages of neighbouring slices
+	struct readahead_s* readahead;
+
 	int realtime;
 	struct io_callback_data rt_callback;
 
+	// stream events only update the latest position, it is shown on the next frame clock tick
+	long rt_latest;
+	bool rt_pending;
+	long rt_dropped;
+
+	// the latest position is processed, but not shown while paused
+	long rt_current;
+	bool rt_paused;
+
+	// the shown frame has arrived after it was rendered, also the reduced plane is made again
+	bool rt_arrived;
+
+	// memory for recent frames
+	long history_budget;
+	bool history_buf;
+	struct history_s* history;
+	struct history_s* history_bufs;
+
+	struct cine_s* cine;
+
+	// rgb and buf do not belong to the last frame, which came from the history or the playback queue
+	bool stale;
+
 	// interpolation buffer
 	complex float* buf;
+	long bufsize;
+	bool buf_valid;
+	bool native;
+
+	// subsampling of a preview in buf, 1 at full quality
+	int coarse;
+
+	// rgb buffer at native resolution
+	unsigned char* nrgb;
+	long nrgbsize;
 
-	// rgb buffer
+	struct reduced_s reduced;
+
+	// rgb buffer, covering the region at (rgbx, rgby) of the zoomed image
+	int rgbx;
+	int rgby;
 	int rgbh;
 	int rgbw;
 	int rgbstr;
 	unsigned char* rgb;
+	long rgbsize;
+
+	// only render around the visible part of the zoomed image
+	bool clip;
+
+	// skip the preview
+	bool refine;
+
+	// visible part of the zoomed image, updated by the GUI
+	int visx;
+	int visy;
+	int visw;
+	int vish;
+
+	// background rendering, buf to rgb and cross_x/cross_y belong to the render thread
+	thrd_t render_thread;
+	cnd_t render_cnd;
+	bool render_request;
+	bool render_busy;
+	bool render_quit;
+
+	// the GUI shows the front frame, the render thread fills the spare frame
+	// and exchanges it with the ready frame, the GUI takes over a fresh ready frame
+	struct frame_s frames[3];
+	struct frame_s* front;
+	struct frame_s* ready;
+	struct frame_s* spare;
+	bool fresh;
 
 	// geometry
 	unsigned long geom_flags;
 	const float (*geom)[3][3];
 	const float (*geom_current)[3][3];
 
+	// cross hair currently drawn into the rgb buffer
+	int cross_x;
+	int cross_y;
+
 	// windowing
 	int lastx;
 	int lasty;
@@ -80,6 +333,11 @@ struct view_control_s {
 
 static void view_window_nosync(struct view_s* v, enum mode_t mode, double winlow, double winhigh);
 static void view_geom2(struct view_s* v);
+static void view_render_sync(struct view_s* v);
+static bool history_load_buf(struct history_s* h, const struct frame_key_s* key, struct view_s* v);
+static void history_store_buf(struct history_s* h, const struct frame_key_s* key, struct view_s* v);
+static void buf_key(struct frame_key_s* key, const struct view_s* v);
+static void clear_status_bar(struct view_s* v);
 
 #ifdef HAS_BART_STREAM
 static void add_rt_callback(struct view_s *ptr);
@@ -115,6 +373,22 @@ static void add_text(cairo_surface_t* surface, int x, int y, int size, const cha
 }
 #endif
 
+// reallocate only if the size changed
+static void* resize_buffer(void* buf, long* cur, long size)
+{
+	if (size == *cur)
+		return buf;
+
+	void* newbuf = realloc(buf, size);
+
+	if (NULL == newbuf)
+		abort();
+
+	*cur = size;
+
+	return newbuf;
+}
+
 bool view_acquire(struct view_s* v, bool wait)
 {
 	if (wait)
@@ -174,65 +448,108 @@ void view_sync(struct view_s* v)
 	}
 }
 
-void view_refresh(struct view_s* v)
+// maximum of the magnitude over the whole data set, out-of-core only over the slices scanned so far unless asked
+static double view_global_max(struct view_s* v, bool scan)
 {
-	if (v->settings.absolute_windowing) {
-
-		long idims[DIMS];
-		md_select_dims(DIMS, MD_BIT(v->settings.xdim) | MD_BIT(v->settings.ydim), idims, v->control->dims);
+	unsigned long flags = MD_BIT(v->settings.xdim) | MD_BIT(v->settings.ydim);
 
-		complex float* tmp = md_alloc(DIMS, idims, sizeof(complex float));
+	struct slice_stats_s s;
 
-		long pos[DIMS];
-		md_copy_dims(DIMS, pos, v->settings.pos);
-		pos[v->settings.xdim] = 0;
-		pos[v->settings.ydim] = 0;
-
-		md_slice(DIMS, ~(MD_BIT(v->settings.xdim) | MD_BIT(v->settings.ydim)), pos, v->control->dims, tmp, v->control->data, sizeof(complex float));
+	// out-of-core, all data is scanned on a helper thread, meanwhile the slices seen so far are used
+	if (scan && (0 < v->control->resident) && stats_scan_background(v->control->stats)) {
 
-		long size = md_calc_size(DIMS, idims);
+		v->control->scanning = true;
+		ui_request_tick(v);
 
-		double max = 0.;
-		for (long j = 0; j < size; j++)
-			if (max < cabsf(tmp[j]))
-				max = cabsf(tmp[j]);
-
-		max = MIN(1.e10, max);
+		scan = false;
+	}
 
-		md_free(tmp);
+	if (scan || (0 == v->control->resident)) {
 
-		if (0 == v->control->max) {
+		s = stats_global(v->control->stats, flags);
+		v->control->stats_known = 1.;
 
-			v->settings.winhigh = max;
-			v->control->max = max;
-		}
+	} else {
 
-		if (v->control->max < max)
-			v->control->max = max;
+		stats_slice(v->control->stats, flags, v->settings.pos);
+		s = stats_known(v->control->stats, flags, &v->control->stats_known);
+	}
 
-	} else {
+	double max = MIN(1.e10, s.max);
 
-		long size = md_calc_size(DIMS, v->control->dims);
-		double max = 0.;
+	if (0. == max)
+		max = 1.;
 
-		for (long j = 0; j < size; j++)
-			if (max < cabsf(v->control->data[j]))
-				max = cabsf(v->control->data[j]);
+	return max;
+}
 
-		max = MIN(1.e10, max);
+// with absolute windowing, the range is the largest maximum seen so far
+static void view_update_max(struct view_s* v, double max)
+{
+	max = MIN(1.e10, max);
 
-		if (0. == max)
-			max = 1.;
+	if (0 == v->control->max) {
 
+		v->settings.winhigh = max;
 		v->control->max = max;
 	}
 
+	if (v->control->max < max)
+		v->control->max = max;
+}
+
+static void view_refresh_ui(struct view_s* v)
+{
 	v->ui_params.windowing_max = v->control->max;
 
 	ui_set_params(v, v->ui_params, v->settings);
 	ui_trigger_redraw(v);
 }
 
+// out-of-core, each slice shown is added to the partial statistics, also for a later switch to relative windowing
+static void view_stats_shown(struct view_s* v)
+{
+	if ((0 == v->control->resident) || !(v->control->stats_known < 1.))
+		return;
+
+	double max = view_global_max(v, false);
+
+	if (v->settings.absolute_windowing)
+		return;
+
+	v->control->max = max;
+	v->ui_params.windowing_max = v->control->max;
+
+	if (!v->control->status_bar && !v->control->scanning)
+		clear_status_bar(v);
+}
+
+static void view_refresh2(struct view_s* v, bool scan)
+{
+	if (v->settings.absolute_windowing) {
+
+		unsigned long flags = MD_BIT(v->settings.xdim) | MD_BIT(v->settings.ydim);
+
+		view_update_max(v, stats_slice(v->control->stats, flags, v->settings.pos).max);
+
+	} else {
+
+		v->control->max = view_global_max(v, scan);
+	}
+
+	// out-of-core, the status bar shows when the statistics are partial
+	if ((0 < v->control->resident) && !v->control->status_bar)
+		clear_status_bar(v);
+
+	view_refresh_ui(v);
+}
+
+// asked for, so all data is scanned also out-of-core
+void view_refresh(struct view_s* v)
+{
+	view_refresh2(v, true);
+}
+
 
 void view_add_geometry(struct view_s* v, unsigned long flags, const float (*geom)[3][3])
 {
@@ -327,6 +644,8 @@ static void view_geom2(struct view_s* v)
 
 	update_geom(v);
 
+	view_stats_shown(v);
+
 	ui_set_params(v, v->ui_params, v->settings);
 	ui_trigger_redraw(v);
 }
@@ -347,11 +666,246 @@ void view_window(struct view_s* v, enum mode_t mode, double winlow, double winhi
 	view_sync(v);
 }
 
+static const complex float* view_reduced_plane(struct view_s* v, int fx, int fy, long rdims[DIMS])
+{
+	struct reduced_s* r = &v->control->reduced;
+
+	long pos[DIMS];
+	md_copy_dims(DIMS, pos, v->settings.pos);
+	pos[v->settings.xdim] = 0;
+	pos[v->settings.ydim] = 0;
+
+	bool mag = (NLINEARMAG == v->settings.interpolation);
+
+	if (   (NULL == r->data)
+	    || !md_check_equal_dims(DIMS, pos, r->pos, ~0UL)
+	    || (r->xdim != v->settings.xdim) || (r->ydim != v->settings.ydim)
+	    || (r->fx != fx) || (r->fy != fy) || (r->mag != mag)) {
+
+		long size = ((v->control->dims[v->settings.xdim] + fx - 1) / fx)
+			  * ((v->control->dims[v->settings.ydim] + fy - 1) / fy);
+
+		void* newbuf = realloc(r->data, size * sizeof(complex float));
+
+		if (NULL == newbuf)
+			abort();
+
+		r->data = newbuf;
+
+		reduce_plane(v->settings.xdim, v->settings.ydim, DIMS, v->control->dims, v->control->rstrs, pos,
+			fx, fy, mag, r->dims, r->data, v->control->rdata);
+
+		md_copy_dims(DIMS, r->pos, pos);
+		r->xdim = v->settings.xdim;
+		r->ydim = v->settings.ydim;
+		r->fx = fx;
+		r->fy = fy;
+		r->mag = mag;
+	}
+
+	md_copy_dims(DIMS, rdims, r->dims);
+
+	return r->data;
+}
+
+static bool view_use_reduced(const struct view_s* v, int* fx, int* fy)
+{
+	*fx = reduce_factor(v->settings.xzoom);
+	*fy = reduce_factor(v->settings.yzoom);
+
+	return    !v->settings.plot && (1 < *fx * *fy)
+	       && ((NLINEAR == v->settings.interpolation) || (NLINEARMAG == v->settings.interpolation));
+}
+
+// estimated cost (in interpolated pixels) above which a preview is shown first
+#ifndef PREVIEW_COST
+#define PREVIEW_COST (1 << 22)
+#endif
+
+static int preview_factor(const struct view_s* v, bool refine)
+{
+	int fx, fy;
+
+	if (v->control->native || v->settings.plot || refine || view_use_reduced(v, &fx, &fy))
+		return 1;
+
+	long cost = (long)v->control->rgbw * v->control->rgbh;
+
+	// no separable fast path
+	if (LIINCO == v->settings.interpolation)
+		cost *= 16;
+
+	if (cost <= PREVIEW_COST)
+		return 1;
+
+	int p = 2;
+
+	while ((p < 16) && (cost > (long)(PREVIEW_COST / 16) * p * p))
+		p *= 2;
+
+	return p;
+}
+
+// region of the preview covering the rgb buffer
+static void coarse_region(const struct view_s* v, int* x0, int* y0, int* w, int* h)
+{
+	int p = v->control->coarse;
+
+	*x0 = v->control->rgbx / p;
+	*y0 = v->control->rgby / p;
+	*w = (v->control->rgbx + v->control->rgbw + p - 1) / p - *x0;
+	*h = (v->control->rgby + v->control->rgbh + p - 1) / p - *y0;
+}
+
+// number of samples in buf
+static long buf_size(const struct view_s* v)
+{
+	long size = v->control->native ? (v->control->dims[v->settings.xdim] * v->control->dims[v->settings.ydim])
+					: (v->control->rgbh * v->control->rgbw);
+
+	if (1 < v->control->coarse) {
+
+		int x0, y0, w, h;
+		coarse_region(v, &x0, &y0, &w, &h);
+
+		size = w * h;
+	}
+
+	return size;
+}
+
 static void update_buf_view(struct view_s* v)
 {
-	update_buf(v->settings.xdim, v->settings.ydim, DIMS, v->control->dims, v->control->strs, v->settings.pos,
+	v->control->buf = resize_buffer(v->control->buf, &v->control->bufsize, buf_size(v) * (long)sizeof(complex float));
+	v->control->buf_valid = true;
+
+	if (1 < v->control->coarse) {
+
+		int p = v->control->coarse;
+		int x0, y0, w, h;
+		coarse_region(v, &x0, &y0, &w, &h);
+
+		update_buf_region(v->settings.xdim, v->settings.ydim, DIMS, v->control->dims, v->control->rstrs, v->settings.pos,
+			v->settings.flip, v->settings.interpolation, v->settings.xzoom / p, v->settings.yzoom / p, false,
+			x0, y0, w, h, v->control->rdata, v->control->buf);
+
+		return;
+	}
+
+	int fx, fy;
+
+	if (view_use_reduced(v, &fx, &fy)) {
+
+		long rdims[DIMS];
+		const complex float* plane = view_reduced_plane(v, fx, fy, rdims);
+
+		long rstrs[DIMS];
+		md_calc_strides(DIMS, rstrs, rdims, sizeof(complex float));
+
+		long rpos[DIMS] = { 0 };
+
+		update_buf_region(v->settings.xdim, v->settings.ydim, DIMS, rdims, rstrs, rpos,
+			v->settings.flip, NLINEAR, v->settings.xzoom * fx, v->settings.yzoom * fy, false,
+			v->control->rgbx, v->control->rgby, v->control->rgbw, v->control->rgbh, plane, v->control->buf);
+
+		return;
+	}
+
+	if (v->control->native) {
+
+		update_buf(v->settings.xdim, v->settings.ydim, DIMS, v->control->dims, v->control->rstrs, v->settings.pos,
+			v->settings.flip, v->settings.interpolation, 1., 1., v->settings.plot,
+			v->control->dims[v->settings.xdim], v->control->dims[v->settings.ydim], v->control->rdata, v->control->buf);
+
+		return;
+	}
+
+	update_buf_region(v->settings.xdim, v->settings.ydim, DIMS, v->control->dims, v->control->rstrs, v->settings.pos,
 		v->settings.flip, v->settings.interpolation, v->settings.xzoom, v->settings.yzoom, v->settings.plot,
-		v->control->rgbw, v->control->rgbh, v->control->data, v->control->buf);
+		v->control->rgbx, v->control->rgby, v->control->rgbw, v->control->rgbh, v->control->rdata, v->control->buf);
+}
+
+// interpolate and colorize in one pass without filling buf
+static bool view_fused(const struct view_s* v)
+{
+	return !v->control->native && (1 == v->control->coarse) && !v->settings.plot;
+}
+
+static void draw_fused_view(struct view_s* v, float scale)
+{
+	assert(view_fused(v));
+
+	unsigned char (*rgb)[v->control->rgbh][v->control->rgbstr / 4][4] = (void*)v->control->rgb;
+
+	int fx, fy;
+
+	if (view_use_reduced(v, &fx, &fy)) {
+
+		long rdims[DIMS];
+		const complex float* plane = view_reduced_plane(v, fx, fy, rdims);
+
+		long rstrs[DIMS];
+		md_calc_strides(DIMS, rstrs, rdims, sizeof(complex float));
+
+		long rpos[DIMS] = { 0 };
+
+		update_draw_region(v->settings.xdim, v->settings.ydim, DIMS, rdims, rstrs, rpos,
+			v->settings.flip, NLINEAR, v->settings.xzoom * fx, v->settings.yzoom * fy,
+			v->control->rgbx, v->control->rgby, v->control->rgbw, v->control->rgbh, v->control->rgbstr, rgb,
+			v->settings.mode, v->settings.colortable, scale, v->settings.winlow, v->settings.winhigh, v->settings.phrot,
+			plane);
+
+		return;
+	}
+
+	update_draw_region(v->settings.xdim, v->settings.ydim, DIMS, v->control->dims, v->control->rstrs, v->settings.pos,
+		v->settings.flip, v->settings.interpolation, v->settings.xzoom, v->settings.yzoom,
+		v->control->rgbx, v->control->rgby, v->control->rgbw, v->control->rgbh, v->control->rgbstr, rgb,
+		v->settings.mode, v->settings.colortable, scale, v->settings.winlow, v->settings.winhigh, v->settings.phrot,
+		v->control->rdata);
+}
+
+static void draw_buf_view(struct view_s* v, float scale)
+{
+	if (!v->control->buf_valid)
+		update_buf_view(v);
+
+	if (v->control->native || (1 < v->control->coarse)) {
+
+		int nw = v->control->dims[v->settings.xdim];
+		int nh = v->control->dims[v->settings.ydim];
+		int x0 = v->control->rgbx;
+		int y0 = v->control->rgby;
+		int rx = v->settings.xzoom;
+		int ry = v->settings.yzoom;
+
+		if (!v->control->native) {
+
+			int cx, cy;
+			coarse_region(v, &cx, &cy, &nw, &nh);
+
+			x0 -= cx * v->control->coarse;
+			y0 -= cy * v->control->coarse;
+			rx = v->control->coarse;
+			ry = v->control->coarse;
+		}
+
+		v->control->nrgb = resize_buffer(v->control->nrgb, &v->control->nrgbsize, nh * nw * 4);
+
+		draw(nw, nh, 4 * nw, (unsigned char(*)[nh][nw][4])v->control->nrgb,
+			v->settings.mode, v->settings.colortable, scale, v->settings.winlow, v->settings.winhigh, v->settings.phrot,
+			nw, v->control->buf);
+
+		draw_replicate(v->control->rgbw, v->control->rgbh, v->control->rgbstr, (unsigned char(*)[v->control->rgbh][v->control->rgbstr / 4][4])v->control->rgb,
+			x0, y0, rx, ry, nw, nh, 4 * nw, (const unsigned char(*)[nh][nw][4])v->control->nrgb);
+
+		return;
+	}
+
+	(v->settings.plot ? draw_plot : draw)(v->control->rgbw, v->control->rgbh, v->control->rgbstr,
+		(unsigned char(*)[v->control->rgbw][v->control->rgbstr / 4][4])v->control->rgb,
+		v->settings.mode, v->settings.colortable, scale, v->settings.winlow, v->settings.winhigh, v->settings.phrot,
+		v->control->rgbw, v->control->buf);
 }
 
 
@@ -363,24 +917,39 @@ char *construct_filename_view2(struct view_s* v)
 	return construct_filename_view(DIMS, loopdims, v->settings.pos, v->name, "png");
 }
 
+// render the whole image at full quality, e.g. for export
+static void view_noclip(struct view_s* v, bool noclip)
+{
+	v->control->clip = !noclip;
+	v->control->refine = noclip;
+	v->control->invalid = true;
+}
+
 bool view_save_png(struct view_s* v, const char *filename)
 {
-	return gtk_ui_save_png(v, filename);
+	view_noclip(v, true);
+	view_render_sync(v);
+
+	bool ret = gtk_ui_save_png(v, filename);
+
+	view_noclip(v, false);
+	ui_trigger_redraw(v);
+
+	return ret;
 }
 
 
 bool view_save_pngmovie(struct view_s* v, const char *folder)
 {
 	int frame_dim = 10;
+	bool ret = false;
 
 	for (int f = 0; f < v->control->dims[frame_dim]; f++) {
 
 		v->settings.pos[frame_dim] = f;
-		update_buf_view(v);
 
-		draw(v->control->rgbw, v->control->rgbh, v->control->rgbstr, (unsigned char(*)[v->control->rgbw][v->control->rgbstr / 4][4])v->control->rgb,
-			v->settings.mode, v->settings.colortable, 1. / v->control->max, v->settings.winlow, v->settings.winhigh, v->settings.phrot,
-			v->control->rgbw, v->control->buf);
+		view_noclip(v, true);
+		view_render_sync(v);
 
 		char output_name[256];
 		int len = snprintf(output_name, 256, "%s/mov-%04d.png", folder, f);
@@ -398,10 +967,13 @@ bool view_save_pngmovie(struct view_s* v, const char *folder)
 		}
 	}
 
-	return true;
+	ret = true;
 
 fail:
-	return false;
+	view_noclip(v, false);
+	ui_trigger_redraw(v);
+
+	return ret;
 }
 
 
@@ -453,8 +1025,23 @@ static void screen2pos(const struct view_s* v, float (*pos)[DIMS], struct xy_s x
 
 
 
+// the windowing is based on the slices seen so far
+static bool view_stats_partial(struct view_s* v)
+{
+	return !v->settings.absolute_windowing && (v->control->stats_known < 1.);
+}
+
 static void clear_status_bar(struct view_s* v)
 {
+	if (view_stats_partial(v)) {
+
+		char buf[100];
+		snprintf(buf, 100, "Statistics of %.3g%% of the data, refresh to scan all", 100. * v->control->stats_known);
+
+		ui_set_msg(v, buf);
+		return;
+	}
+
 	char buf = '\0';
 	ui_set_msg(v, &buf);
 }
@@ -473,73 +1060,904 @@ static void update_status_bar(struct view_s* v)
 	complex float val = sample(DIMS, posf, v->control->dims, v->control->strs, v->settings.interpolation, v->control->data);
 
 	// FIXME: make sure this matches exactly the pixel
-	char buf[100];
-	snprintf(buf, 100, "Pos: %03d %03d Magn: %.3e Val: %+.3e%+.3ei Arg: %+.2f", x2, y2,
+	char buf[130];
+	int n = snprintf(buf, 130, "Pos: %03d %03d Magn: %.3e Val: %+.3e%+.3ei Arg: %+.2f", x2, y2,
 			cabsf(val), crealf(val), cimagf(val), cargf(val));
 
+	if (view_stats_partial(v) && (n < 130))
+		snprintf(buf + n, 130 - n, " Stats: %.3g%% only", 100. * v->control->stats_known);
+
 	ui_set_msg(v, buf);
 }
 
 
-void view_draw(struct view_s* v)
+static float view_scale(struct view_s* v)
 {
-	v->control->rgbw = v->control->dims[v->settings.xdim] * v->settings.xzoom;
-	v->control->rgbh = v->control->dims[v->settings.ydim] * v->settings.yzoom;
-	v->control->rgbstr = 4 * v->control->rgbw;
-
-	if (v->control->invalid) {
-
-		v->control->buf = realloc(v->control->buf, v->control->rgbh * v->control->rgbw * sizeof(complex float));
+	return v->settings.absolute_windowing ? 1. : 1. / v->control->max;
+}
 
+// restore the pixels below the cross hair drawn previously
+static void clear_cross_hair(struct view_s* v, float scale)
+{
+	if (!v->control->buf_valid)
 		update_buf_view(v);
 
-		v->control->invalid = false;
-		v->control->rgb_invalid = true;
+	if (v->control->native || (1 < v->control->coarse) || v->settings.plot) {
+
+		draw_buf_view(v, scale);
+		return;
 	}
 
-	if (v->control->rgb_invalid) {
+	int X = v->control->rgbw;
+	int Y = v->control->rgbh;
+	int T = tiles_count(X, Y);
 
-		ui_rgbbuffer_disconnect(v);
+	bool* mask = xmalloc(T * sizeof(bool));
 
-		void *newbuf = realloc(v->control->rgb, v->control->rgbh * v->control->rgbstr);
+	for (int i = 0; i < T; i++)
+		mask[i] = false;
 
-		if (NULL == newbuf)
-			abort();
+	int cx = v->control->cross_x - v->control->rgbx;
+	int cy = v->control->cross_y - v->control->rgby;
 
-		v->control->rgb = newbuf;
+	tiles_mark(X, Y, mask, 0, cy, X - 1, cy);
+	tiles_mark(X, Y, mask, cx, 0, cx, Y - 1);
 
-		ui_rgbbuffer_connect(v, v->control->rgbw, v->control->rgbh, v->control->rgbstr, v->control->rgb);
+	draw_tiles(X, Y, v->control->rgbstr, (unsigned char(*)[Y][v->control->rgbstr / 4][4])v->control->rgb,
+		v->settings.mode, v->settings.colortable, scale, v->settings.winlow, v->settings.winhigh, v->settings.phrot,
+		X, v->control->buf, mask);
 
-		(v->settings.plot ? draw_plot : draw)(v->control->rgbw, v->control->rgbh, v->control->rgbstr,
-			(unsigned char(*)[v->control->rgbw][v->control->rgbstr / 4][4])v->control->rgb,
-			v->settings.mode, v->settings.colortable, v->settings.absolute_windowing ? 1. : 1. / v->control->max, v->settings.winlow, v->settings.winhigh, v->settings.phrot,
-			v->control->rgbw, v->control->buf);
+	xfree(mask);
 
-		v->control->rgb_invalid = false;
-	}
+	v->control->cross_x = -1;
+	v->control->cross_y = -1;
+}
+
+// does the region contain the visible part of the zoomed image
+static bool region_covers(int x, int y, int w, int h, int width, int height, int vx, int vy, int vw, int vh)
+{
+	return    (x <= vx) && (MIN(width, vx + vw) <= x + w)
+	       && (y <= vy) && (MIN(height, vy + vh) <= y + h);
+}
+
+// choose the region of the zoomed image which is rendered into the rgb buffer
+static bool view_region(struct view_s* v, const struct render_job_s* job, int width, int height)
+{
+	int x0 = 0;
+	int y0 = 0;
+	int x1 = width;
+	int y1 = height;
+
+	if (job->clip && !v->settings.plot) {
+
+		// keep the current region as long as it covers the visible part
+		if (   !job->invalid
+		    && region_covers(v->control->rgbx, v->control->rgby, v->control->rgbw, v->control->rgbh,
+				width, height, job->visx, job->visy, job->visw, job->vish))
+			return false;
+
+		// margin of half a page in each direction for scrolling
+		x0 = MAX(0, job->visx - job->visw / 2);
+		y0 = MAX(0, job->visy - job->vish / 2);
+		x1 = MIN(width, job->visx + job->visw + job->visw / 2);
+		y1 = MIN(height, job->visy + job->vish + job->vish / 2);
+
+		if ((x1 <= x0) || (y1 <= y0)) {
+
+			x0 = 0;
+			y0 = 0;
+			x1 = width;
+			y1 = height;
+		}
+	}
+
+	if (   (x0 == v->control->rgbx) && (y0 == v->control->rgby)
+	    && (x1 - x0 == v->control->rgbw) && (y1 - y0 == v->control->rgbh))
+		return false;
+
+	v->control->rgbx = x0;
+	v->control->rgby = y0;
+	v->control->rgbw = x1 - x0;
+	v->control->rgbh = y1 - y0;
+
+	return true;
+}
+
+// runs in the render thread on a snapshot of the settings
+static void view_render(struct view_s* v, const struct render_job_s* job)
+{
+	int width = v->control->dims[v->settings.xdim] * v->settings.xzoom;
+	int height = v->control->dims[v->settings.ydim] * v->settings.yzoom;
+
+	bool invalid = view_region(v, job, width, height) || job->invalid || v->control->stale;
+	bool rgb_invalid = job->rgb_invalid;
+
+	v->control->stale = false;
+
+	v->control->rgbstr = 4 * v->control->rgbw;
+
+	if (invalid) {
+
+		v->control->native = native_zoom(v->settings.interpolation, v->settings.xzoom, v->settings.yzoom, v->settings.plot);
+		v->control->coarse = preview_factor(v, job->refine);
+		v->control->buf_valid = false;
+	}
+
+	// keep the interpolated images of full-quality frames, so that the windowing can change without interpolation
+	struct history_s* h = v->control->history_bufs;
+	bool keep_buf = (0 < job->history) && job->history_buf && (1 == v->control->coarse);
+
+	struct frame_key_s bkey;
+
+	if (keep_buf) {
+
+		buf_key(&bkey, v);
+
+		if (invalid)
+			v->control->buf_valid = history_load_buf(h, &bkey, v);
+	}
+
+	if (invalid || rgb_invalid) {
+
+		v->control->rgb = resize_buffer(v->control->rgb, &v->control->rgbsize, v->control->rgbh * v->control->rgbstr);
+
+		bool fill = !v->control->buf_valid;
+
+		// buf is only filled once the windowing changes for the same image
+		if (invalid && view_fused(v) && !keep_buf) {
+
+			draw_fused_view(v, job->scale);
+
+		} else {
+
+			draw_buf_view(v, job->scale);
+
+			if (keep_buf && fill)
+				history_store_buf(h, &bkey, v);
+		}
+
+		v->control->cross_x = -1;
+		v->control->cross_y = -1;
+	}
+
+	struct xy_s cross = { -1, -1 };
+
+	if (v->settings.cross_hair) {
+
+		float posf[DIMS];
+		for (int i = 0; i < DIMS; i++)
+			posf[i] = v->settings.pos[i];
+
+		cross = pos2screen(v, posf);
+	}
+
+	if (   (-1 != v->control->cross_x)
+	    && (((int)cross.x != v->control->cross_x) || ((int)cross.y != v->control->cross_y)))
+		clear_cross_hair(v, job->scale);
+
+	// add_text(v->ui->source, 3, 3, 10, v->name);
+
+	if (v->settings.cross_hair) {
+
+		v->control->cross_x = (int)cross.x;
+		v->control->cross_y = (int)cross.y;
+
+		// relative to the rendered region
+		int cx = (int)cross.x - v->control->rgbx;
+		int cy = (int)cross.y - v->control->rgby;
+
+		if ((0 <= cy) && (cy < v->control->rgbh))
+			draw_line(v->control->rgbw, v->control->rgbh, v->control->rgbstr, (unsigned char (*)[v->control->rgbw][v->control->rgbstr / 4][4])v->control->rgb,
+				0, cy, v->control->rgbw - 1, cy, (v->settings.xdim > v->settings.ydim) ? &color_red : &color_blue);
+
+		if ((0 <= cx) && (cx < v->control->rgbw))
+			draw_line(v->control->rgbw, v->control->rgbh, v->control->rgbstr, (unsigned char (*)[v->control->rgbw][v->control->rgbstr / 4][4])v->control->rgb,
+				cx, 0, cx, v->control->rgbh - 1, (v->settings.xdim < v->settings.ydim) ? &color_red : &color_blue);
+
+//		float coords[4][2] = { { 0, 0 }, { 100, 0 }, { 0, 100 }, { 100, 100 } };
+//		draw_grid(v->control->rgbw, v->control->rgbh, v->control->rgbstr, (unsigned char (*)[v->control->rgbw][v->control->rgbstr / 4][4])v->control->rgb, &coords, 4, &color_white);
+	}
+}
+
+// copy the rendered image into the spare frame
+static void view_publish(struct view_s* v)
+{
+	struct frame_s* f = v->control->spare;
+
+	f->rgb = resize_buffer(f->rgb, &f->size, v->control->rgbh * v->control->rgbstr);
+
+	memcpy(f->rgb, v->control->rgb, v->control->rgbh * v->control->rgbstr);
+
+	f->x = v->control->rgbx;
+	f->y = v->control->rgby;
+	f->w = v->control->rgbw;
+	f->h = v->control->rgbh;
+	f->str = v->control->rgbstr;
+	f->width = v->control->dims[v->settings.xdim] * v->settings.xzoom;
+	f->height = v->control->dims[v->settings.ydim] * v->settings.yzoom;
+
+	f->cross_hair = v->settings.cross_hair;
+	f->cross_pos[0] = v->settings.pos[v->settings.xdim];
+	f->cross_pos[1] = v->settings.pos[v->settings.ydim];
+}
+
+static void frame_copy(struct frame_s* dst, const struct frame_s* src)
+{
+	dst->rgb = resize_buffer(dst->rgb, &dst->size, src->h * src->str);
+
+	memcpy(dst->rgb, src->rgb, src->h * src->str);
+
+	dst->x = src->x;
+	dst->y = src->y;
+	dst->w = src->w;
+	dst->h = src->h;
+	dst->str = src->str;
+	dst->width = src->width;
+	dst->height = src->height;
+
+	dst->cross_hair = src->cross_hair;
+	dst->cross_pos[0] = src->cross_pos[0];
+	dst->cross_pos[1] = src->cross_pos[1];
+}
+
+static void frame_key(struct frame_key_s* key, const struct view_s* v, float scale)
+{
+	// compared with memcmp
+	memset(key, 0, sizeof(struct frame_key_s));
+
+	md_copy_dims(DIMS, key->pos, v->settings.pos);
+
+	// the position in the plane only matters for the cross hair and plots
+	if (!v->settings.cross_hair) {
+
+		key->pos[v->settings.xdim] = 0;
+
+		if (!v->settings.plot)
+			key->pos[v->settings.ydim] = 0;
+	}
+
+	key->xdim = v->settings.xdim;
+	key->ydim = v->settings.ydim;
+	key->xzoom = v->settings.xzoom;
+	key->yzoom = v->settings.yzoom;
+	key->flip = v->settings.flip;
+	key->mode = v->settings.mode;
+	key->ctab = v->settings.colortable;
+	key->interpolation = v->settings.interpolation;
+	key->winlow = v->settings.winlow;
+	key->winhigh = v->settings.winhigh;
+	key->phrot = v->settings.phrot;
+	key->scale = scale;
+	key->cross_hair = v->settings.cross_hair;
+	key->plot = v->settings.plot;
+}
+
+// key of the interpolated image in buf
+static void buf_key(struct frame_key_s* key, const struct view_s* v)
+{
+	frame_key(key, v, 0.);
+
+	key->pos[v->settings.xdim] = 0;
+
+	if (!v->settings.plot)
+		key->pos[v->settings.ydim] = 0;
+
+	key->mode = MAGN;
+	key->ctab = NONE;
+	key->winlow = 0.;
+	key->winhigh = 0.;
+	key->phrot = 0.;
+	key->cross_hair = false;
+
+	key->layer = LAYER_BUF;
+	key->region[0] = v->control->rgbx;
+	key->region[1] = v->control->rgby;
+	key->region[2] = v->control->rgbw;
+	key->region[3] = v->control->rgbh;
+	key->native = v->control->native;
+}
+
+static unsigned long frame_key_hash(const struct frame_key_s* key)
+{
+	// FNV-1a, the padding of keys is zero
+	const unsigned char* p = (const unsigned char*)key;
+	unsigned long hash = 14695981039346656037UL;
+
+	for (size_t i = 0; i < sizeof(struct frame_key_s); i++)
+		hash = (hash ^ p[i]) * 1099511628211UL;
+
+	return hash;
+}
+
+// drop the least recently used frame
+static void history_evict(struct history_s* h)
+{
+	int lru = 0;
+
+	for (int i = 1; i < h->count; i++)
+		if (h->entry[i].used < h->entry[lru].used)
+			lru = i;
+
+	struct history_entry_s* e = &h->entry[lru];
+
+	h->bytes -= e->frame.size + e->buf.size;
+
+	free(e->frame.rgb);
+	free(e->buf.data);
+
+	h->count--;
+	h->entry[lru] = h->entry[h->count];
+	h->entry[h->count].frame = (struct frame_s){ .rgb = NULL, .size = 0 };
+	h->entry[h->count].buf = (struct history_buf_s){ .data = NULL, .size = 0 };
+}
+
+static struct history_entry_s* history_find(struct history_s* h, const struct frame_key_s* key)
+{
+	unsigned long hash = frame_key_hash(key);
+
+	for (int i = 0; i < h->count; i++) {
+
+		struct history_entry_s* e = &h->entry[i];
+
+		if ((hash == e->hash) && (0 == memcmp(&e->key, key, sizeof(struct frame_key_s)))) {
+
+			e->used = ++h->clock;
+			return e;
+		}
+	}
+
+	return NULL;
+}
+
+// can the frame be shown for the job
+static bool frame_covers(const struct frame_s* f, const struct view_s* v, const struct render_job_s* job)
+{
+	if (job->clip && !v->settings.plot)
+		return region_covers(f->x, f->y, f->w, f->h, f->width, f->height, job->visx, job->visy, job->visw, job->vish);
+
+	return (0 == f->x) && (0 == f->y) && (f->w == f->width) && (f->h == f->height);
+}
+
+// a frame which can be shown for the job, if any
+static const struct frame_s* history_lookup(struct history_s* h, const struct frame_key_s* key, const struct view_s* v, const struct render_job_s* job)
+{
+	struct history_entry_s* e = history_find(h, key);
+
+	if ((NULL == e) || !frame_covers(&e->frame, v, job))
+		return NULL;
+
+	return &e->frame;
+}
+
+// the entry for key, a new one if there is room for size bytes
+static struct history_entry_s* history_entry(struct history_s* h, const struct frame_key_s* key, long size)
+{
+	struct history_entry_s* e = history_find(h, key);
+
+	if (NULL != e)
+		return e;
+
+	if (size > h->budget)
+		return NULL;
+
+	while ((0 < h->count) && ((h->bytes + size > h->budget) || (HISTORY_FRAMES == h->count)))
+		history_evict(h);
+
+	e = &h->entry[h->count++];
+	e->key = *key;
+	e->hash = frame_key_hash(key);
+	e->used = ++h->clock;
+
+	return e;
+}
+
+static void history_insert(struct history_s* h, const struct frame_key_s* key, const struct frame_s* f)
+{
+	struct history_entry_s* e = history_entry(h, key, (long)f->h * f->str);
+
+	if (NULL == e)
+		return;
+
+	h->bytes -= e->frame.size;
+
+	frame_copy(&e->frame, f);
+
+	h->bytes += e->frame.size;
+}
+
+static struct history_s* create_history(void)
+{
+	struct history_s* h = xmalloc(sizeof(struct history_s));
+
+	h->budget = 0;
+	h->bytes = 0;
+	h->clock = 0;
+	h->count = 0;
+
+	for (int i = 0; i < HISTORY_FRAMES; i++) {
+
+		h->entry[i].frame = (struct frame_s){ .rgb = NULL, .size = 0 };
+		h->entry[i].buf = (struct history_buf_s){ .data = NULL, .size = 0 };
+	}
+
+	return h;
+}
+
+static void history_free(struct history_s* h)
+{
+	while (0 < h->count)
+		history_evict(h);
+
+	xfree(h);
+}
+
+// the interpolated image kept from an earlier frame, e.g. before a change of the windowing
+static bool history_load_buf(struct history_s* h, const struct frame_key_s* key, struct view_s* v)
+{
+	struct history_entry_s* e = history_find(h, key);
+
+	if (NULL == e)
+		return false;
+
+	v->control->buf = resize_buffer(v->control->buf, &v->control->bufsize, e->buf.size);
+
+	memcpy(v->control->buf, e->buf.data, e->buf.size);
+
+	return true;
+}
+
+static void history_store_buf(struct history_s* h, const struct frame_key_s* key, struct view_s* v)
+{
+	long size = buf_size(v) * (long)sizeof(complex float);
+
+	struct history_entry_s* e = history_entry(h, key, size);
+
+	if (NULL == e)
+		return;
+
+	h->bytes -= e->buf.size;
+
+	e->buf.data = resize_buffer(e->buf.data, &e->buf.size, size);
+
+	memcpy(e->buf.data, v->control->buf, size);
+
+	h->bytes += e->buf.size;
+}
+
+
+static double view_time(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + 1.E-9 * ts.tv_nsec;
+}
+
+// frame of the playback which is due at time t
+static long cine_due(const struct cine_s* cn, double t)
+{
+	return (long)((t - cn->t0) * cn->fps);
+}
+
+static void cine_key(struct frame_key_s* key, const struct cine_s* cn, struct view_s* v, long seq)
+{
+	frame_key(key, v, view_scale(v));
+
+	key->pos[cn->dim] = (cn->start + seq) % cn->len;
+}
+
+// was the frame rendered with the current settings
+static bool cine_match(const struct cine_s* cn, struct view_s* v, const struct cine_slot_s* s)
+{
+	struct frame_key_s key;
+	cine_key(&key, cn, v, s->seq);
+
+	return 0 == memcmp(&key, &s->key, sizeof(struct frame_key_s));
+}
+
+// next frame to render ahead of the playback, called with the lock held
+static struct cine_slot_s* cine_claim(struct cine_s* cn, long* seq)
+{
+	struct view_s* v = cn->v;
+	struct cine_slot_s* free_slot = NULL;
+
+	for (int i = 0; i < CINE_QUEUE; i++) {
+
+		struct cine_slot_s* s = &cn->queue[i];
+
+		// late or rendered with other settings, the frame shown waits for the render thread
+		if (s->done && ((s->seq < cn->shown) || !cine_match(cn, v, s))) {
+
+			s->seq = -1;
+			s->done = false;
+		}
+
+		if (-1 == s->seq)
+			free_slot = s;
+	}
+
+	if (NULL == free_slot)
+		return NULL;
+
+	// frames which are due already would be late
+	long next = MAX(cn->shown, cine_due(cn, view_time())) + 1;
+
+	for (long n = next; n < next + CINE_QUEUE; n++) {
+
+		bool queued = false;
+
+		for (int i = 0; i < CINE_QUEUE; i++)
+			if ((n == cn->queue[i].seq) && cine_match(cn, v, &cn->queue[i]))
+				queued = true;
+
+		if (!queued) {
+
+			*seq = n;
+			return free_slot;
+		}
+	}
+
+	return NULL;
+}
+
+// rendered frame of the playback for the job, called with the lock held
+static struct cine_slot_s* cine_find(struct cine_s* cn, const struct frame_key_s* key, const struct view_s* v, const struct render_job_s* job)
+{
+	for (int i = 0; i < CINE_QUEUE; i++) {
+
+		struct cine_slot_s* s = &cn->queue[i];
+
+		if (   s->done && (0 == memcmp(&s->key, key, sizeof(struct frame_key_s)))
+		    && frame_covers(&s->frame, v, job))
+			return s;
+	}
+
+	return NULL;
+}
+
+// renders frames ahead of the playback into the queue, with buffers of its own
+static int cine_worker(void* _cn)
+{
+	struct cine_s* cn = _cn;
+	struct view_s* v = cn->v;
+	struct view_control_s* c = v->control;
+
+	struct view_control_s* wc = xmalloc(sizeof(struct view_control_s));
+	memset(wc, 0, sizeof(struct view_control_s));
+
+	md_copy_dims(DIMS, wc->dims, c->dims);
+	md_copy_dims(DIMS, wc->strs, c->strs);
+	md_copy_dims(DIMS, wc->rstrs, c->strs);
+	wc->data = c->data;
+	wc->rdata = c->data;
+	wc->cross_x = -1;
+	wc->cross_y = -1;
+
+	long pos[DIMS];
+
+	mtx_lock(&c->mx);
+
+	while (!cn->quit) {
+
+		long seq;
+		struct cine_slot_s* s = cine_claim(cn, &seq);
+
+		if (NULL == s) {
+
+			cnd_wait(&cn->cnd, &c->mx);
+			continue;
+		}
+
+		struct view_s rv = *v;
+		md_copy_dims(DIMS, pos, v->settings.pos);
+		pos[cn->dim] = (cn->start + seq) % cn->len;
+		rv.settings.pos = pos;
+		rv.control = wc;
+
+		struct render_job_s job = {
+
+			.invalid = true,
+			.refine = true,
+			.clip = c->clip,
+			.visx = c->visx,
+			.visy = c->visy,
+			.visw = c->visw,
+			.vish = c->vish,
+			.scale = view_scale(v),
+		};
+
+		s->seq = seq;
+		s->done = false;
+		cine_key(&s->key, cn, v, seq);
+
+		mtx_unlock(&c->mx);
+
+		view_render(&rv, &job);
+
+		wc->spare = &s->frame;
+		view_publish(&rv);
+
+		mtx_lock(&c->mx);
+
+		s->done = true;
+	}
+
+	mtx_unlock(&c->mx);
+
+	free(wc->buf);
+	free(wc->rgb);
+	free(wc->nrgb);
+	free(wc->reduced.data);
+	xfree(wc);
+
+	return 0;
+}
+
+// called with the lock held, which is released while the workers finish
+static void cine_stop(struct view_s* v)
+{
+	struct cine_s* cn = v->control->cine;
+
+	if (NULL == cn)
+		return;
+
+	cn->quit = true;
+	cnd_broadcast(&cn->cnd);
+
+	mtx_unlock(&v->control->mx);
+
+	for (int i = 0; i < CINE_WORKERS; i++)
+		thrd_join(cn->workers[i], NULL);
+
+	mtx_lock(&v->control->mx);
+
+	v->control->cine = NULL;
+
+	for (int i = 0; i < CINE_QUEUE; i++)
+		free(cn->queue[i].frame.rgb);
+
+	cnd_destroy(&cn->cnd);
+	xfree(cn);
+}
+
+// called from the helper thread of the layout, the GUI picks up the copy when it draws next
+static void view_layout_ready(void* _v)
+{
+	ui_frame_ready(_v);
+}
+
+static int render_thread(void* _v)
+{
+	struct view_s* v = _v;
+	struct view_control_s* c = v->control;
+
+	long pos[DIMS];
+
+	mtx_lock(&c->mx);
+
+	while (!c->render_quit) {
+
+		if (!c->render_request) {
+
+			cnd_wait(&c->render_cnd, &c->mx);
+			continue;
+		}
+
+		c->render_request = false;
+
+		// snapshot, so that the GUI can change the settings meanwhile
+		struct view_s rv = *v;
+		md_copy_dims(DIMS, pos, v->settings.pos);
+		rv.settings.pos = pos;
+
+		struct render_job_s job = {
+
+			.invalid = c->invalid,
+			.rgb_invalid = c->rgb_invalid,
+			.refine = c->refine,
+			.clip = c->clip,
+			.visx = c->visx,
+			.visy = c->visy,
+			.visw = c->visw,
+			.vish = c->vish,
+			.scale = view_scale(v),
+			.history = c->history_budget,
+			.history_buf = c->history_buf,
+		};
+
+		c->invalid = false;
+		c->rgb_invalid = false;
+		c->refine = false;
+		c->render_busy = true;
+
+		// only used by the render thread
+		if (c->rt_arrived) {
+
+			free(c->reduced.data);
+			c->reduced.data = NULL;
+
+			c->rt_arrived = false;
+		}
+
+		// frames of a stream beyond the latest one are rendered from data not yet written, they are not kept
+		if ((0 <= c->realtime) && (pos[c->realtime] > c->rt_current))
+			job.history = 0;
+
+		if (job.invalid)
+			readahead_position(c->readahead, MD_BIT(rv.settings.xdim) | MD_BIT(rv.settings.ydim), pos);
+
+		// nobody else reads the copy, so it can be replaced here
+		if (c->layout_copy != (NULL != c->layout)) {
+
+			if (NULL == c->layout) {
+
+				c->layout = create_layout(DIMS, c->dims, c->data, view_layout_ready, v);
+				c->layout_copy = (NULL != c->layout);
+
+			} else {
 
+				delete_layout(c->layout);
+				c->layout = NULL;
+			}
+		}
 
-	// add_text(v->ui->source, 3, 3, 10, v->name);
+		c->rdata = layout_plane(c->layout, rv.settings.xdim, rv.settings.ydim, c->rstrs);
 
-	if (v->settings.cross_hair) {
+		if (NULL == c->rdata) {
 
-		float posf[DIMS];
-		for (int i = 0; i < DIMS; i++)
-			posf[i] = v->settings.pos[i];
+			c->rdata = c->data;
+			md_copy_dims(DIMS, c->rstrs, c->strs);
+		}
 
-		struct xy_s xy = pos2screen(v, posf);
+		struct frame_key_s key;
+		frame_key(&key, &rv, job.scale);
 
-		draw_line(v->control->rgbw, v->control->rgbh, v->control->rgbstr, (unsigned char (*)[v->control->rgbw][v->control->rgbstr / 4][4])v->control->rgb,
-				0, (int)xy.y, v->control->rgbw - 1, (int)xy.y, (v->settings.xdim > v->settings.ydim) ? &color_red : &color_blue);
+		// taken over from the playback queue
+		struct cine_slot_s* cs = (NULL != c->cine) ? cine_find(c->cine, &key, &rv, &job) : NULL;
 
-		draw_line(v->control->rgbw, v->control->rgbh, v->control->rgbstr, (unsigned char (*)[v->control->rgbw][v->control->rgbstr / 4][4])v->control->rgb,
-				(int)xy.x, 0, (int)xy.x, v->control->rgbh - 1, (v->settings.xdim < v->settings.ydim) ? &color_red : &color_blue);
+		if (NULL != cs) {
 
-//		float coords[4][2] = { { 0, 0 }, { 100, 0 }, { 0, 100 }, { 100, 100 } };
-//		draw_grid(v->control->rgbw, v->control->rgbh, v->control->rgbstr, (unsigned char (*)[v->control->rgbw][v->control->rgbstr / 4][4])v->control->rgb, &coords, 4, &color_white);
+			struct frame_s tmp = *c->spare;
+			*c->spare = cs->frame;
+			cs->frame = tmp;
+
+			cs->seq = -1;
+			cs->done = false;
+
+			cnd_broadcast(&c->cine->cnd);
+		}
+
+		mtx_unlock(&c->mx);
+
+		if ((0 < job.history) && (NULL == c->history))
+			c->history = create_history();
+
+		if ((0 < job.history) && job.history_buf && (NULL == c->history_bufs))
+			c->history_bufs = create_history();
+
+		// interpolated images are kept separately, with half of the memory
+		if (0 < job.history)
+			c->history->budget = job.history_buf ? (job.history / 2) : job.history;
+
+		if ((0 < job.history) && job.history_buf)
+			c->history_bufs->budget = job.history / 2;
+
+		const struct frame_s* hf = NULL;
+
+		if ((NULL == cs) && (0 < job.history))
+			hf = history_lookup(c->history, &key, &rv, &job);
+
+		if ((NULL != cs) || (NULL != hf)) {
+
+			if (NULL != hf)
+				frame_copy(c->spare, hf);
+			else if (0 < job.history)
+				history_insert(c->history, &key, c->spare);
+
+			c->stale = true;
+			c->coarse = 1;
+
+		} else {
+
+			view_render(&rv, &job);
+			view_publish(&rv);
+
+			// only full-quality frames
+			if ((0 < job.history) && (1 == c->coarse))
+				history_insert(c->history, &key, c->spare);
+		}
+
+		mtx_lock(&c->mx);
+
+		struct frame_s* f = c->ready;
+		c->ready = c->spare;
+		c->spare = f;
+		c->fresh = true;
+
+		ui_frame_ready(v);
+
+		// continue with the full-quality image unless superseded
+		if ((1 < c->coarse) && !c->render_request) {
+
+			c->refine = true;
+			c->invalid = true;
+			c->render_request = true;
+		}
+
+		c->render_busy = false;
+		cnd_broadcast(&c->render_cnd);
 	}
 
-	if (v->control->status_bar)
+	mtx_unlock(&c->mx);
+
+	return 0;
+}
+
+static void view_request(struct view_s* v)
+{
+	v->control->render_request = true;
+	cnd_broadcast(&v->control->render_cnd);
+}
+
+// connect the last finished frame to the GUI
+static void view_present(struct view_s* v)
+{
+	if (!v->control->fresh)
+		return;
+
+	struct frame_s* f = v->control->ready;
+	v->control->ready = v->control->front;
+	v->control->front = f;
+	v->control->fresh = false;
+
+	ui_set_size(v, f->width, f->height);
+	ui_rgbbuffer_connect(v, f->x, f->y, f->w, f->h, f->str, f->rgb);
+}
+
+// render the current settings and wait for the result, called with the lock held
+static void view_render_sync(struct view_s* v)
+{
+	view_request(v);
+
+	while (v->control->render_request || v->control->render_busy)
+		cnd_wait(&v->control->render_cnd, &v->control->mx);
+
+	view_present(v);
+}
+
+void view_draw(struct view_s* v)
+{
+	struct view_control_s* c = v->control;
+
+	view_present(v);
+
+	const struct frame_s* f = c->front;
+
+	int width = c->dims[v->settings.xdim] * v->settings.xzoom;
+	int height = c->dims[v->settings.ydim] * v->settings.yzoom;
+
+	ui_get_viewport(v, &c->visx, &c->visy, &c->visw, &c->vish);
+
+	// a copy of the data for the shown plane is ready now, which is faster to render from
+	if (layout_poll(c->layout))
+		c->invalid = true;
+
+	bool request = c->invalid || c->rgb_invalid;
+
+	if (   (f->cross_hair != v->settings.cross_hair)
+	    || (   v->settings.cross_hair
+		&& (   (f->cross_pos[0] != v->settings.pos[v->settings.xdim])
+		    || (f->cross_pos[1] != v->settings.pos[v->settings.ydim]))))
+		request = true;
+
+	if (   c->clip && !v->settings.plot
+	    && !region_covers(f->x, f->y, f->w, f->h, width, height, c->visx, c->visy, c->visw, c->vish))
+		request = true;
+
+	if (request && !c->render_busy)
+		view_request(v);
+
+	if (c->status_bar)
 		update_status_bar(v);
 }
 
@@ -597,11 +2015,48 @@ struct view_s* create_view(const char* name, const long pos[DIMS], const long di
 	md_calc_strides(DIMS, v->control->strs, dims, sizeof(complex float));
 
 	v->control->data = data;
+	v->control->rdata = data;
+	md_copy_dims(DIMS, v->control->rstrs, v->control->strs);
+	v->control->layout_copy = false;
+	v->control->layout = NULL;
+	v->control->stats = create_stats(DIMS, dims, data);
+	v->control->stats_known = 1.;
+	v->control->resident = 0;
+	v->control->scanning = false;
+	v->control->readahead = NULL;
 	v->control->rgb = NULL;
+	v->control->rgbsize = 0;
 	v->control->buf = NULL;
+	v->control->bufsize = 0;
+	v->control->buf_valid = false;
+	v->control->native = false;
+	v->control->nrgb = NULL;
+	v->control->nrgbsize = 0;
+	v->control->rgbx = 0;
+	v->control->rgby = 0;
+	v->control->rgbw = 0;
+	v->control->rgbh = 0;
+	v->control->clip = true;
+	v->control->coarse = 1;
+	v->control->refine = false;
+	v->control->reduced.data = NULL;
 	v->control->status_bar = false;
 	v->control->max = 0.;
 
+	v->control->realtime = -1;
+	v->control->rt_latest = 0;
+	v->control->rt_pending = false;
+	v->control->rt_dropped = 0;
+	v->control->rt_current = 0;
+	v->control->rt_paused = false;
+	v->control->rt_arrived = false;
+	v->control->history_budget = 0;
+	v->control->history_buf = false;
+	v->control->history = NULL;
+	v->control->history_bufs = NULL;
+	v->control->cine = NULL;
+	v->control->stale = false;
+
 	v->control->geom_flags = 0ul;
 	v->control->geom = NULL;
 	v->control->geom_current = NULL;
@@ -609,12 +2064,36 @@ struct view_s* create_view(const char* name, const long pos[DIMS], const long di
 	v->control->lastx = -1;
 	v->control->lasty = -1;
 
+	v->control->cross_x = -1;
+	v->control->cross_y = -1;
+
 	v->control->aniso = 1;
 	v->control->transpose = true;
 
 	v->control->invalid = true;
 
+	v->control->visx = 0;
+	v->control->visy = 0;
+	v->control->visw = 0;
+	v->control->vish = 0;
+
+	v->control->render_request = false;
+	v->control->render_busy = false;
+	v->control->render_quit = false;
+
+	for (int i = 0; i < 3; i++)
+		v->control->frames[i] = (struct frame_s){ .rgb = NULL, .size = 0, .cross_hair = false };
+
+	v->control->front = &v->control->frames[0];
+	v->control->ready = &v->control->frames[1];
+	v->control->spare = &v->control->frames[2];
+	v->control->fresh = false;
+
 	mtx_init(&v->control->mx, mtx_plain);
+	cnd_init(&v->control->render_cnd);
+
+	if (thrd_success != thrd_create(&v->control->render_thread, render_thread, v))
+		error("Could not start render thread.\n");
 
 	return v;
 }
@@ -625,8 +2104,33 @@ static void delete_view(struct view_s* v)
 	v->next->prev = v->prev;
 	v->prev->next = v->next;
 
+	mtx_lock(&v->control->mx);
+	cine_stop(v);
+	v->control->render_quit = true;
+	cnd_broadcast(&v->control->render_cnd);
+	mtx_unlock(&v->control->mx);
+
+	thrd_join(v->control->render_thread, NULL);
+	cnd_destroy(&v->control->render_cnd);
+
+	ui_rgbbuffer_disconnect(v);
+
+	for (int i = 0; i < 3; i++)
+		free(v->control->frames[i].rgb);
 	free(v->control->buf);
 	free(v->control->rgb);
+	free(v->control->nrgb);
+	free(v->control->reduced.data);
+
+	delete_stats(v->control->stats);
+	delete_readahead(v->control->readahead);
+	delete_layout(v->control->layout);
+
+	if (NULL != v->control->history)
+		history_free(v->control->history);
+
+	if (NULL != v->control->history_bufs)
+		history_free(v->control->history_bufs);
 
 	free(v->ui_params.selected);
 
@@ -649,26 +2153,91 @@ static void view_set_windowing(struct view_s* v)
 	v->ui_params.windowing_digits = MAX(3, 3 - (int)round(log(max) / log(10.)));
 }
 
-void view_toggle_absolute_windowing(struct view_s* v, bool state)
+// histogram matching the current windowing
+static const struct histogram_s* view_stats_histogram(struct view_s* v)
 {
-	if (state && v->settings.absolute_windowing)
+	unsigned long flags = MD_BIT(v->settings.xdim) | MD_BIT(v->settings.ydim);
+
+	if (v->settings.absolute_windowing || (v->control->stats_known < 1.))
+		return stats_histogram_slice(v->control->stats, flags, v->settings.pos);
+
+	return stats_histogram_global(v->control->stats, flags);
+}
+
+// set the window between two percentiles of the magnitude
+void view_auto_window(struct view_s* v, double plow, double phigh)
+{
+	const struct histogram_s* h = view_stats_histogram(v);
+
+	double scale = v->settings.absolute_windowing ? 1. : (1. / v->control->max);
+
+	double winlow = MIN(v->ui_params.windowing_max, stats_percentile(h, plow) * scale);
+	double winhigh = MIN(v->ui_params.windowing_max, stats_percentile(h, phigh) * scale);
+
+	if (winhigh <= winlow)
 		return;
 
-	if (v->settings.absolute_windowing) {
+	view_window(v, v->settings.mode, winlow, winhigh);
+	ui_set_params(v, v->ui_params, v->settings);
+}
+
+/*
+ * Histogram of the shown slice with log counts over the logarithmic bins
+ * in use, resampled to N bins and normalized to one, and the position of
+ * the window in it. It is drawn often, so it never scans all data.
+ */
+bool view_histogram(struct view_s* v, int N, float bins[N], double* low, double* high)
+{
+	unsigned long flags = MD_BIT(v->settings.xdim) | MD_BIT(v->settings.ydim);
 
-		long size = md_calc_size(DIMS, v->control->dims);
-		double max = 0.;
+	const struct histogram_s* h = stats_histogram_slice(v->control->stats, flags, v->settings.pos);
 
-		for (long j = 0; j < size; j++)
-			if (max < cabsf(v->control->data[j]))
-				max = cabsf(v->control->data[j]);
+	if (0. == h->max)
+		return false;
 
-		max = MIN(1.e10, max);
+	// skip empty bins at the bottom, the first one collects zeros
+	int b0 = 1;
 
-		if (0. == max)
-			max = 1.;
+	while ((b0 < STATS_BINS - 1) && (0 == h->bins[b0]))
+		b0++;
 
-		v->control->max = max;
+	int nb = STATS_BINS - b0;
+
+	float hmax = 0.f;
+
+	for (int i = 0; i < N; i++) {
+
+		int j0 = b0 + (int)((long)i * nb / N);
+		int j1 = MAX(j0 + 1, b0 + (int)((long)(i + 1) * nb / N));
+
+		long c = 0;
+
+		for (int j = j0; j < j1; j++)
+			c += h->bins[j];
+
+		bins[i] = log1pf(c);
+		hmax = MAX(hmax, bins[i]);
+	}
+
+	for (int i = 0; i < N; i++)
+		bins[i] = (0.f == hmax) ? 0.f : (bins[i] / hmax);
+
+	double scale = v->settings.absolute_windowing ? 1. : v->control->max;
+
+	*low = (stats_histogram_position(h, v->settings.winlow * scale) - b0) / nb;
+	*high = (stats_histogram_position(h, v->settings.winhigh * scale) - b0) / nb;
+
+	return true;
+}
+
+void view_toggle_absolute_windowing(struct view_s* v, bool state)
+{
+	if (state && v->settings.absolute_windowing)
+		return;
+
+	if (v->settings.absolute_windowing) {
+
+		v->control->max = view_global_max(v, false);
 		v->settings.winhigh = MIN(v->settings.winhigh / v->control->max, 1);
 		v->settings.winlow = MIN(v->settings.winlow / v->control->max, 1);
 
@@ -716,7 +2285,7 @@ void view_click(struct view_s* v, int x, int y, int button)
 		view_set_position(v, pos);
 	}
 
-	v->control->rgb_invalid = true;
+	// the old cross hair is removed by the render thread
 	ui_trigger_redraw(v);
 }
 
@@ -775,12 +2344,23 @@ void view_window_close(struct view_s* v)
 
 
 struct view_s* window_new(const char* name, const long pos[DIMS], const long dims[DIMS], const complex float* x,
-		bool absolute_windowing, enum color_t ctab, int realtime)
+		bool absolute_windowing, enum color_t ctab, int realtime, bool stats_cache, long resident)
 {
 	struct view_s* v = create_view(name, pos, dims, x);
 
 	view_acquire(v, true);
 
+	// statistics from earlier sessions, streamed data changes
+	if (stats_cache && (0 > realtime))
+		stats_attach_file(v->control->stats, name);
+
+	// a stream is kept in memory
+	if (0 > realtime) {
+
+		v->control->resident = resident;
+		stats_set_budget(v->control->stats, resident);
+	}
+
 	v->settings.absolute_windowing = absolute_windowing;
 	v->settings.colortable = ctab;
 
@@ -789,18 +2369,36 @@ struct view_s* window_new(const char* name, const long pos[DIMS], const long dim
 
 	ui_configure(v);
 
-	view_refresh(v);
+	// statistics only of the frames which have arrived
+	if (0 <= realtime)
+		stats_set_stream(v->control->stats, realtime, v->settings.pos[realtime] + 1);
+
+	view_refresh2(v, false);
 	view_geom2(v);
 	view_set_windowing(v);
+
+	stats_save(v->control->stats, true);
 	view_window(v, v->settings.mode, v->settings.winlow, v->settings.winhigh);
 
 	ui_set_params(v, v->ui_params, v->settings);
 
 	v->control->realtime = realtime;
 
+	// a stream is not backed by the file
+	if (0 > realtime) {
+
+		v->control->readahead = create_readahead(DIMS, dims, x);
+		readahead_set_budget(v->control->readahead, resident);
+	}
+
 #ifdef HAS_BART_STREAM
 	if (0 <= realtime) {
 
+		v->control->rt_latest = v->settings.pos[realtime];
+		v->control->rt_current = v->settings.pos[realtime];
+
+		ui_set_realtime(v);
+
 		view_ff_realtime_position(v);
 		add_rt_callback(v);
 	}
@@ -826,7 +2424,10 @@ void window_connect_sync(struct view_s* v, struct view_s* v2)
 struct view_s* view_window_clone(struct view_s* v)
 {
 	struct view_s* v2 = window_new(v->name, v->settings.pos, v->control->dims, v->control->data,
-			v->settings.absolute_windowing, v->settings.colortable, v->control->realtime);
+			v->settings.absolute_windowing, v->settings.colortable, v->control->realtime, false, v->control->resident);
+
+	view_set_history(v2, v->control->history_budget, v->control->history_buf);
+	view_set_layout(v2, v->control->layout_copy);
 
 	window_connect_sync(v, v2);
 
@@ -856,6 +2457,272 @@ void view_toggle_plot(struct view_s* v)
 }
 
 
+static void view_tick_realtime(struct view_s* v)
+{
+	struct view_control_s* control = v->control;
+
+	control->rt_pending = false;
+
+	long latest = control->rt_latest;
+	bool update = false;
+
+	if (latest > control->rt_current) {
+
+		// the new frames are read in place, unless another view of the stream did already
+		struct slice_stats_s s = stats_append(control->stats, control->realtime, control->rt_current + 1, latest + 1);
+
+		if (v->settings.absolute_windowing)
+			view_update_max(v, s.max);
+
+		// frames which arrived since the last tick are never shown
+		if (!control->rt_paused)
+			control->rt_dropped += latest - control->rt_current - 1;
+
+		// e.g. while paused, the shown frame was rendered from data not yet written
+		long shown = v->settings.pos[control->realtime];
+
+		if ((control->rt_current < shown) && (shown <= latest)) {
+
+			control->invalid = true;
+			control->rt_arrived = true;
+		}
+
+		control->rt_current = latest;
+		update = true;
+	}
+
+	if (!control->rt_paused && (latest != v->settings.pos[control->realtime])) {
+
+		v->settings.pos[control->realtime] = latest;
+		ui_set_params(v, v->ui_params, v->settings);
+		view_sync(v);
+
+		// the position callbacks cannot take the lock held here
+		control->invalid = true;
+		update = true;
+	}
+
+	if (update) {
+
+		if (v->settings.absolute_windowing)
+			view_refresh_ui(v);
+		else
+			view_refresh(v);
+
+		if (!control->status_bar) {
+
+			char buf[100];
+			snprintf(buf, 100, "Frame: %ld Dropped: %ld%s", latest, control->rt_dropped,
+					control->rt_paused ? " (paused)" : "");
+
+			ui_set_msg(v, buf);
+		}
+	}
+}
+
+// show the latest frame of the playback which is ready and due
+static void view_tick_cine(struct view_s* v)
+{
+	struct view_control_s* control = v->control;
+	struct cine_s* cn = control->cine;
+
+	double now = view_time();
+	long due = cine_due(cn, now);
+
+	struct render_job_s job = {
+
+		.clip = control->clip,
+		.visx = control->visx,
+		.visy = control->visy,
+		.visw = control->visw,
+		.vish = control->vish,
+	};
+
+	struct cine_slot_s* next = NULL;
+
+	for (int i = 0; i < CINE_QUEUE; i++) {
+
+		struct cine_slot_s* s = &cn->queue[i];
+
+		if (   s->done && (cn->shown < s->seq) && (s->seq <= due)
+		    && ((NULL == next) || (next->seq < s->seq))
+		    && cine_match(cn, v, s) && frame_covers(&s->frame, v, &job))
+			next = s;
+	}
+
+	if (NULL != next) {
+
+		cn->dropped += next->seq - cn->shown - 1;
+		cn->shown = next->seq;
+		cn->rate_frames++;
+
+		v->settings.pos[cn->dim] = (cn->start + next->seq) % cn->len;
+		ui_set_params(v, v->ui_params, v->settings);
+		view_sync(v);
+
+		// taken over by the render thread from the queue
+		control->invalid = true;
+		ui_trigger_redraw(v);
+	}
+
+	if (1. <= now - cn->rate_t0) {
+
+		cn->rate = cn->rate_frames / (now - cn->rate_t0);
+		cn->rate_t0 = now;
+		cn->rate_frames = 0;
+	}
+
+	if (!control->status_bar) {
+
+		char buf[100];
+		snprintf(buf, 100, "Cine: %ld/%ld FPS: %.1f (%.1f) Dropped: %ld",
+				v->settings.pos[cn->dim], cn->len, cn->rate, cn->fps, cn->dropped);
+
+		ui_set_msg(v, buf);
+	}
+
+	// the workers continue after the frame shown
+	cnd_broadcast(&cn->cnd);
+
+	ui_request_tick(v);
+}
+
+// called once per frame of the display after ui_request_tick
+// progress of the scan of all data, the windowing follows when it has finished
+static void view_tick_scan(struct view_s* v)
+{
+	double progress;
+
+	if (stats_scan_poll(v->control->stats, &progress)) {
+
+		if (!v->control->status_bar) {
+
+			char buf[100];
+			snprintf(buf, 100, "Scanning all data: %.0f%%", 100. * progress);
+
+			ui_set_msg(v, buf);
+		}
+
+		ui_request_tick(v);
+		return;
+	}
+
+	v->control->scanning = false;
+
+	view_refresh2(v, false);
+}
+
+void view_tick(struct view_s* v)
+{
+	view_acquire(v, true);
+
+	if (v->control->rt_pending)
+		view_tick_realtime(v);
+
+	if (v->control->scanning)
+		view_tick_scan(v);
+
+	if (NULL != v->control->cine)
+		view_tick_cine(v);
+
+	view_release(v);
+}
+
+// play along dim, a non-positive rate stops the playback
+void view_cine(struct view_s* v, int dim, double fps)
+{
+	struct view_control_s* control = v->control;
+
+	bool playing = (NULL != control->cine);
+
+	cine_stop(v);
+
+	if (0. >= fps) {
+
+		// the last frame may come from the queue
+		if (playing) {
+
+			control->invalid = true;
+			ui_trigger_redraw(v);
+		}
+
+		return;
+	}
+
+	// not along the image axes, a stream is only partially available along its dimension
+	if (   (dim < 0) || (DIMS <= dim) || (1 == control->dims[dim])
+	    || (dim == v->settings.xdim) || (dim == v->settings.ydim) || (dim == control->realtime)) {
+
+		ui_set_msg(v, "Cine: cannot play along this dimension.");
+		return;
+	}
+
+	struct cine_s* cn = xmalloc(sizeof(struct cine_s));
+
+	cn->dim = dim;
+	cn->len = control->dims[dim];
+	cn->fps = fps;
+	cn->start = v->settings.pos[dim];
+	cn->t0 = view_time();
+	cn->shown = 0;
+	cn->dropped = 0;
+	cn->rate_t0 = cn->t0;
+	cn->rate_frames = 0;
+	cn->rate = 0.;
+
+	for (int i = 0; i < CINE_QUEUE; i++) {
+
+		cn->queue[i].seq = -1;
+		cn->queue[i].done = false;
+		cn->queue[i].frame = (struct frame_s){ .rgb = NULL, .size = 0 };
+	}
+
+	cn->quit = false;
+	cn->v = v;
+	cnd_init(&cn->cnd);
+
+	control->cine = cn;
+
+	for (int i = 0; i < CINE_WORKERS; i++)
+		if (thrd_success != thrd_create(&cn->workers[i], cine_worker, cn))
+			error("Could not start cine worker.\n");
+
+	ui_request_tick(v);
+}
+
+// stop following the stream, recent frames are shown from the history
+void view_pause(struct view_s* v, bool paused)
+{
+	v->control->rt_paused = paused;
+
+	if ((0 <= v->control->realtime) && !v->control->rt_pending) {
+
+		v->control->rt_pending = true;
+		ui_request_tick(v);
+	}
+}
+
+// memory for recently shown frames, optionally also for their interpolated images, then half of it for each
+void view_set_history(struct view_s* v, long bytes, bool buf)
+{
+	view_acquire(v, true);
+
+	v->control->history_budget = bytes;
+	v->control->history_buf = buf;
+
+	view_release(v);
+}
+
+// a copy of the data for planes which are not contiguous in memory, not for streams or out-of-core
+void view_set_layout(struct view_s* v, bool copy)
+{
+	view_acquire(v, true);
+
+	v->control->layout_copy = copy && (0 > v->control->realtime) && (0 == v->control->resident);
+
+	view_release(v);
+}
+
 #ifdef HAS_BART_STREAM
 static void view_ff_realtime_position(void *_v)
 {
@@ -872,16 +2739,15 @@ static void view_ff_realtime_position(void *_v)
 	long pos[DIMS] = { 0 };
 	stream_get_latest_pos(s, DIMS, pos);
 
-	long new_pos = pos[control->realtime];
+	if (pos[control->realtime] <= control->rt_latest)
+		return;
 
-	if (new_pos > v->settings.pos[control->realtime]) {
+	control->rt_latest = pos[control->realtime];
 
-		v->settings.pos[control->realtime] = new_pos;
-		ui_set_params(v, v->ui_params, v->settings);
-		view_sync(v);
+	if (!control->rt_pending) {
 
-		control->rgb_invalid = true;
-		view_refresh(v);
+		control->rt_pending = true;
+		ui_request_tick(v);
 	}
 }
 
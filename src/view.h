@@ -71,9 +71,11 @@ struct view_s {
 
 
 // setup etc
-extern struct view_s* window_new(const char* name, const long pos[DIMS], const long dims[DIMS], const _Complex float* x, _Bool absolute_windowing, enum color_t ctab, int realtime);
+extern struct view_s* window_new(const char* name, const long pos[DIMS], const long dims[DIMS], const _Complex float* x, _Bool absolute_windowing, enum color_t ctab, int realtime, _Bool stats_cache, long resident);
 
 extern void window_connect_sync(struct view_s* a, struct view_s* b);
+extern void view_set_history(struct view_s* v, long bytes, _Bool buf);
+extern void view_set_layout(struct view_s* v, _Bool copy);
 
 
 // usually callbacks:
@@ -83,6 +85,9 @@ extern void view_refresh(struct view_s* v);
 extern void view_window(struct view_s* v, enum mode_t mode, double winlow, double winhigh);
 
 extern void view_draw(struct view_s* v);
+extern void view_tick(struct view_s* v);
+extern void view_pause(struct view_s* v, _Bool paused);
+extern void view_cine(struct view_s* v, int dim, double fps);
 
 extern bool view_save_png(struct view_s* v, const char *filename);
 extern bool view_save_pngmovie(struct view_s* v, const char *folder);
@@ -93,6 +98,8 @@ extern void view_click(struct view_s* v, int x, int y, int button);
 
 extern void view_toggle_plot(struct view_s* v);
 extern void view_toggle_absolute_windowing(struct view_s* v, _Bool state);
+extern void view_auto_window(struct view_s* v, double plow, double phigh);
+extern _Bool view_histogram(struct view_s* v, int N, float bins[N], double* low, double* high);
 
 extern void view_add_geometry(struct view_s* v, unsigned long flags, const float (*geom)[3][3]);
 